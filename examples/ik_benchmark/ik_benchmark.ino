@@ -0,0 +1,193 @@
+/*********************************************************************
+ Adafruit invests time and resources providing this open source code,
+ please support Adafruit and open-source hardware by purchasing
+ products from Adafruit!
+
+ MIT license, check LICENSE for more information
+ Copyright (c) 2019 Ha Thach for Adafruit Industries
+ All text above, and the splash screen below must be included in
+ any redistribution
+*********************************************************************/
+
+/* This example measures on the target the parts of the driver whose cost
+ * depends on input, no IntelliKeys is needed:
+ * - word prediction: dictionary footprint in flash and lookup latency for a
+ *   set of prefixes
+ * - touch tracking: IKTouch::update() (blob grouping, centroids and nearest
+ *   key on the QWERTY overlay) for membranes from a single finger up to all
+ *   cells touched
+ *
+ * The dictionary is generated from a word list with
+ *   python3 tools/ik_dict.py tools/words_en.txt -o src/ik_dict_en.h -n ik_dict_en
+ * which also prints its size on the host.
+ */
+
+#include "Adafruit_TinyUSB.h"
+
+#include "IKOverlay.h"
+#include "IKPredict.h"
+#include "IKTouch.h"
+#include "ik_dict_en.h"
+
+// Calls per measurement
+#define ROUNDS 1000
+
+IKPredict predict;
+IKTouch touch;
+
+//--------------------------------------------------------------------+
+// Timing helpers
+//--------------------------------------------------------------------+
+
+// Time per call of func in 1/10 us
+template <typename F> static uint32_t measure(F func) {
+  uint32_t const start = micros();
+  for (uint16_t r = 0; r < ROUNDS; r++) {
+    func();
+  }
+  return (micros() - start) * 10 / ROUNDS;
+}
+
+typedef struct {
+  uint32_t total;
+  uint32_t worst;
+  uint32_t count;
+} stats_t;
+
+static void addTime(stats_t *stats, uint32_t t10) {
+  stats->total += t10;
+  stats->count++;
+  if (t10 > stats->worst) {
+    stats->worst = t10;
+  }
+}
+
+static void printTime(char const *name, uint32_t t10) {
+  Serial.printf("%s: %lu.%lu us", name, t10 / 10, t10 % 10);
+}
+
+static void printStats(stats_t const *stats) {
+  uint32_t const avg10 = stats->count ? stats->total / stats->count : 0;
+  Serial.printf("Average %lu.%lu us, worst %lu.%lu us", avg10 / 10,
+                avg10 % 10, stats->worst / 10, stats->worst % 10);
+}
+
+//--------------------------------------------------------------------+
+// Word prediction
+//--------------------------------------------------------------------+
+
+static char const *const prefixes[] = {
+    "", "t", "th", "the", "wh", "som", "hel", "tomorrow", "xyz", "a",
+};
+
+static void benchmarkPredict(void) {
+  Serial.println("Word Prediction");
+
+  if (!predict.setDictionary(ik_dict_en)) {
+    Serial.println("Invalid dictionary");
+    return;
+  }
+
+  uint32_t const size = predict.getDictionarySize();
+  uint16_t const words = predict.getWordCount();
+  Serial.printf("Dictionary: %u words, %lu bytes (%lu.%lu bytes/word)\r\n",
+                words, size, size / words, (size * 10 / words) % 10);
+  Serial.printf("RAM: %u bytes\r\n", (unsigned)sizeof(IKPredict));
+
+  stats_t stats = {0, 0, 0};
+  for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+    uint8_t count = 0;
+    uint32_t const t10 =
+        measure([&count, i]() { count = predict.lookup(prefixes[i]); });
+    addTime(&stats, t10);
+
+    char name[16];
+    snprintf(name, sizeof(name), "'%s'", prefixes[i]);
+    printTime(name, t10);
+    Serial.printf(", %u words:", count);
+    for (uint8_t w = 0; w < count; w++) {
+      Serial.printf(" %s", predict.getResult(w));
+    }
+    Serial.println();
+  }
+
+  printStats(&stats);
+  Serial.printf(", max %u nodes visited\r\n", predict.getVisitMax());
+}
+
+//--------------------------------------------------------------------+
+// Touch tracking
+//--------------------------------------------------------------------+
+
+typedef struct {
+  char const *name;
+  uint8_t count;      // number of rectangles
+  uint8_t rect[4][4]; // row, col, height, width
+} touch_pattern_t;
+
+static touch_pattern_t const patterns[] = {
+    {"none", 0, {}},
+    {"1 finger", 1, {{10, 10, 2, 2}}},
+    {"1 finger on key border", 1, {{11, 4, 3, 3}}},
+    {"3 fingers", 3, {{4, 2, 2, 2}, {12, 10, 2, 3}, {18, 20, 3, 2}}},
+    {"palm", 1, {{8, 6, 8, 10}}},
+    {"all cells", 1, {{0, 0, IK_RESOLUTION_Y, IK_RESOLUTION_X}}},
+};
+
+static void setPattern(touch_pattern_t const *pattern) {
+  touch.clear();
+  for (uint8_t i = 0; i < pattern->count; i++) {
+    uint8_t const *rect = pattern->rect[i];
+    for (uint8_t row = rect[0]; row < rect[0] + rect[2]; row++) {
+      for (uint8_t col = rect[1]; col < rect[1] + rect[3]; col++) {
+        touch.setCell(row, col, true);
+      }
+    }
+  }
+}
+
+static void benchmarkTouch(void) {
+  Serial.println("Touch Tracking");
+  Serial.printf("RAM: %u bytes\r\n", (unsigned)sizeof(IKTouch));
+
+  IKOverlay::initStandardOverlays();
+  IKOverlay *overlay = &stdOverlays[IK_OVERLAY_QWERTY];
+
+  stats_t stats = {0, 0, 0};
+  for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    setPattern(&patterns[i]);
+
+    uint8_t count = 0;
+    uint32_t const t10 =
+        measure([&count, overlay]() { count = touch.update(overlay); });
+    addTime(&stats, t10);
+
+    printTime(patterns[i].name, t10);
+    Serial.printf(", %u touches:", count);
+    for (uint8_t t = 0; t < count; t++) {
+      ik_touch_t const *tp = touch.getTouch(t);
+      Serial.printf(" (%u.%02u, %u.%02u) %u cells key %u",
+                    tp->y >> IK_TOUCH_FRAC_BITS,
+                    (tp->y & 0xff) * 100 / 256, tp->x >> IK_TOUCH_FRAC_BITS,
+                    (tp->x & 0xff) * 100 / 256, tp->size, tp->key_id);
+    }
+    Serial.println();
+  }
+
+  printStats(&stats);
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) {
+    delay(10);
+  }
+
+  Serial.println("IntelliKeys Benchmark");
+  benchmarkPredict();
+  Serial.println();
+  benchmarkTouch();
+}
+
+void loop() {}
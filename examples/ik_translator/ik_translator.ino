@@ -35,6 +35,27 @@
 
 #include "Adafruit_IntelliKeys.h"
 
+// English word list for prediction keys (IK_REPORT_TYPE_PREDICT) of custom
+// overlays, generated by tools/ik_dict.py
+#include "ik_dict_en.h"
+
+// Cache IntelliKeys calibration in internal flash filesystem so that overlay
+// is recognized right away when board is re-attached. Requires a FAT
+// formatted filesystem region: select Flash Size with FS in "Menu -> Flash
+// Size" and format it once e.g with SdFat_format example of Adafruit SPIFlash
+#ifndef USE_FLASH_CACHE
+#define USE_FLASH_CACHE 1
+#endif
+
+#if USE_FLASH_CACHE
+#include "Adafruit_SPIFlash.h"
+#include "SdFat.h"
+
+Adafruit_FlashTransport_RP2040 flashTransport;
+Adafruit_SPIFlash flash(&flashTransport);
+FatVolume fatfs;
+#endif
+
 // Pin D+ for host, D- = D+ + 1
 #ifndef PIN_USB_HOST_DP
 #define PIN_USB_HOST_DP 16 // 20
@@ -57,7 +78,17 @@
 #define NEOPIXEL_POWER 20
 #endif
 
-#define SCAN_INTERVAL 8
+// Keyboard report is sent only on change, mouse endpoint is polled at the
+// fastest full speed rate so that pointer motion streams smoothly while a
+// mouse key is held
+#define KEYBOARD_INTERVAL 8
+#define MOUSE_INTERVAL 1
+
+// Use N-Key Rollover bitmap keyboard report instead of 6-key boot report.
+// Note: NKRO keyboard is not a boot device and may not work in BIOS
+#ifndef USE_NKRO
+#define USE_NKRO 0
+#endif
 
 // USB Host object
 Adafruit_USBH_Host USBHost;
@@ -66,17 +97,27 @@ Adafruit_IntelliKeys IKeys;
 
 // HID report descriptor for keyboard and mouse
 // Single Report (no ID) descriptor
+#if USE_NKRO
+typedef ik_nkro_keyboard_report_t kb_report_t;
+uint8_t const desc_keyboard_report[] = {
+    TUD_HID_REPORT_DESC_IK_NKRO_KEYBOARD()};
+#define KEYBOARD_PROTOCOL HID_ITF_PROTOCOL_NONE
+#else
+typedef hid_keyboard_report_t kb_report_t;
 uint8_t const desc_keyboard_report[] = {TUD_HID_REPORT_DESC_KEYBOARD()};
+#define KEYBOARD_PROTOCOL HID_ITF_PROTOCOL_KEYBOARD
+#endif
+
 uint8_t const desc_mouse_report[] = {TUD_HID_REPORT_DESC_MOUSE()};
 
 // USB HID object. For ESP32 these values cannot be changed after this
 // declaration desc report, desc len, protocol, interval, use out endpoint
 Adafruit_USBD_HID usb_keyboard(desc_keyboard_report,
-                               sizeof(desc_keyboard_report),
-                               HID_ITF_PROTOCOL_KEYBOARD, 8, false);
+                               sizeof(desc_keyboard_report), KEYBOARD_PROTOCOL,
+                               KEYBOARD_INTERVAL, false);
 
 Adafruit_USBD_HID usb_mouse(desc_mouse_report, sizeof(desc_mouse_report),
-                            HID_ITF_PROTOCOL_MOUSE, 8, false);
+                            HID_ITF_PROTOCOL_MOUSE, MOUSE_INTERVAL, false);
 
 //------------- prototypes -------------//
 enum { PIXEL_BRIGHTNESS = 0x20 };
@@ -110,17 +151,24 @@ void setup() {
 
   setPixel(COLOR_NO_USB);
 
+#if USE_FLASH_CACHE
+  if (flash.begin() && fatfs.begin(&flash)) {
+    IKeys.setFlashVolume(&fatfs);
+  } else {
+    Serial.println("Flash filesystem not found, calibration is not cached");
+  }
+#endif
+
   // while ( !Serial ) delay(10);   // wait for native usb
   Serial.println("IntelliKeys USB Adapter");
 }
 
-bool hasKeyboardReport(hid_keyboard_report_t const *report) {
-  if (report->modifier != 0) {
-    return true;
-  }
-
-  for (uint8_t i = 0; i < 6; i++) {
-    if (report->keycode[i] != 0) {
+bool hasKeyboardReport(kb_report_t const *report) {
+  // both boot and nkro report has modifier + reserved (always 0) followed by
+  // keycodes, any non-zero byte means there is key pressed
+  uint8_t const *buf = (uint8_t const *)report;
+  for (uint8_t i = 0; i < sizeof(kb_report_t); i++) {
+    if (buf[i] != 0) {
       return true;
     }
   }
@@ -128,75 +176,59 @@ bool hasKeyboardReport(hid_keyboard_report_t const *report) {
   return false;
 }
 
-void scanMembraneAndSwitch(void) {
-  static hid_keyboard_report_t kb_prev_report = {0, 0, {0}};
-  static bool kb_has_prev_report = false;
-  static uint8_t mouse_prev_buttons = 0;
+bool kb_pressed = false;
+bool mouse_pressed = false;
 
-  if (!IKeys.isAttached()) {
-    setPixel(COLOR_NO_USB);
+void sendKeyboardReport(void) {
+  // changes are kept in IKeys until endpoint is ready
+  if (!usb_keyboard.ready()) {
     return;
   }
 
-  if (!IKeys.IsOpen() || !IKeys.IsSwitchedOn()) {
-    setPixel(COLOR_NOT_READY);
-    return;
+  kb_report_t kb_report;
+  if (IKeys.getKeyboardReport(&kb_report)) {
+    usb_keyboard.sendReport(0, &kb_report, sizeof(kb_report));
+    kb_pressed = hasKeyboardReport(&kb_report);
   }
+}
 
-  uint32_t color = COLOR_READY;
-
-  hid_keyboard_report_t kb_report;
-  hid_mouse_report_t mouse_report;
-
-  IKeys.getHIDReport(&kb_report, &mouse_report);
-
-  //------------- Keyboard -------------//
-  bool new_kb_report = hasKeyboardReport(&kb_report);
-
-  if (new_kb_report) {
-    if (memcmp(&kb_prev_report, &kb_report, sizeof(kb_report))) {
-      // send only if kb_report is changed since last time
-      usb_keyboard.sendReport(0, &kb_report, sizeof(kb_report));
-    }
-    kb_has_prev_report = true;
-    color = COLOR_KEY_PRESSED;
-  } else {
-    if (kb_has_prev_report) {
-      // has previous report before, send empty kb_report to release all keys
-      hid_keyboard_report_t null_report = {0, 0, {0}};
-      usb_keyboard.sendReport(0, &null_report, sizeof(null_report));
-    }
-    kb_has_prev_report = false;
+void sendMouseReport(void) {
+  if (!usb_mouse.ready()) {
+    return;
   }
 
-  kb_prev_report = kb_report;
-
-  //------------- Mouse -------------//
-  if (mouse_report.buttons != mouse_prev_buttons || mouse_report.x != 0 ||
-      mouse_report.y != 0) {
-    // x,y is only 0, 1, -1
-    enum { MOUSE_SCALE = 1 };
-    mouse_report.x *= MOUSE_SCALE;
-    mouse_report.y *= MOUSE_SCALE;
-
-    // TODO check for IK_REPORT_MOUSE_DOUBLE_CLICK and
-    // IK_REPORT_MOUSE_CLICK_HOLD
+  hid_mouse_report_t mouse_report;
+  if (IKeys.getMouseReport(&mouse_report)) {
+    // x,y is already accelerated according to IKSettings mouse speed, buttons
+    // are HID buttons only: click hold is reported as a held left button
     usb_mouse.sendReport(0, &mouse_report, sizeof(mouse_report));
-    color = COLOR_KEY_PRESSED;
+    mouse_pressed = mouse_report.buttons != 0;
   }
-  mouse_prev_buttons = mouse_report.buttons;
+}
 
-  setPixel(color);
+void updateStatus(void) {
+  if (!IKeys.isAttached()) {
+    setPixel(COLOR_NO_USB);
+  } else if (!IKeys.IsOpen() || !IKeys.IsSwitchedOn()) {
+    setPixel(COLOR_NOT_READY);
+  } else if (kb_pressed || mouse_pressed) {
+    setPixel(COLOR_KEY_PRESSED);
+  } else {
+    setPixel(COLOR_READY);
+  }
 }
 
 void loop() {
-  static uint32_t ms = 0;
+  // both pipelines are cheap when nothing changes, poll them as fast as the
+  // endpoints allow
+  sendKeyboardReport();
+  sendMouseReport();
+  updateStatus();
 
-  // scan every 10 ms
-  if (millis() - ms > SCAN_INTERVAL) {
-    ms = millis();
-    scanMembraneAndSwitch();
-  }
+  // smart typing toggled by its overlay key and calibration cache are stored
+  // from here, the volume is only used by this core. Writes are rare, they
+  // still pause the USB host core for the time flash is programmed.
+  IKeys.saveChangedSettings();
 
   Serial.flush();
 }
@@ -207,6 +239,7 @@ void loop() {
 
 void setup1() {
   IKeys.begin();
+  IKeys.setDictionary(ik_dict_en);
 
   //  while (!Serial) {
   //    delay(10); // wait for native usb
@@ -120,27 +120,86 @@ const char *const ik_event_str[] = {
 #define IK_PRINTF2(...)
 #endif
 
+static_assert(IK_TIMER_COUNT <= IK_TIMER_MAX, "IK_TIMER_MAX is too small");
+
 //--------------------------------------------------------------------+
 // Public API
 //--------------------------------------------------------------------+
 
 Adafruit_IntelliKeys::Adafruit_IntelliKeys(void)
-    : m_modShift(KEYBOARD_MODIFIER_LEFTSHIFT),
-      m_modAlt(KEYBOARD_MODIFIER_LEFTALT),
-      m_modControl(KEYBOARD_MODIFIER_LEFTCTRL),
-      m_modCommand(KEYBOARD_MODIFIER_LEFTGUI) {
+    : m_filter(&m_timer, IK_TIMER_FILTER), m_scan(&m_timer, IK_TIMER_SCAN) {
+  memset(m_repeatFlags, 0, sizeof(m_repeatFlags));
+  m_repeatLatchCount = 0;
   Reset();
 
   _membrane_cb = NULL;
   _switch_cb = NULL;
   _toggle_cb = NULL;
+  _scan_cb = NULL;
 
   _custom_overlay = NULL;
   _custom_overlay_count = 0;
+  _custom_overlay_req = NULL;
+  _custom_overlay_req_count = 0;
+  _custom_overlay_seq = 0;
+  _custom_overlay_applied = 0;
+
+  m_touchMode = false;
+  m_touchModeRequest = false;
+  m_mouseAccessTrackpad = false;
+  m_mouseAccessTrackpadApplied = false;
+  m_trackpadMode = IK_TRACKPAD_RELATIVE;
+
+  // default switch overlay: switch 1 and 2 are mouse left and right click,
+  // the others are Space, Enter, Tab and Backspace
+  memset(m_switchOverlays, 0, sizeof(m_switchOverlays));
+  ik_report_t *sw = m_switchOverlays[0].switches;
+  sw[0].type = sw[1].type = IK_REPORT_TYPE_MOUSE;
+  sw[0].mouse.buttons = MOUSE_BUTTON_LEFT;
+  sw[1].mouse.buttons = MOUSE_BUTTON_RIGHT;
+  uint8_t const sw_keycode[] = {HID_KEY_SPACE, HID_KEY_ENTER, HID_KEY_TAB,
+                                HID_KEY_BACKSPACE};
+  for (uint8_t i = 0; i < TU_ARRAY_SIZE(sw_keycode); i++) {
+    sw[2 + i].type = IK_REPORT_TYPE_KEYBOARD;
+    sw[2 + i].keyboard.keycode = sw_keycode[i];
+  }
+  m_switchOverlay = 0;
+  memcpy(m_switchOverlayRequest.overlays, m_switchOverlays,
+         sizeof(m_switchOverlays));
+  m_switchOverlayRequest.select = 0;
+  m_switchOverlaySeq = 0;
+  m_switchOverlayApplied = 0;
+
+  m_scanSwitch = 0;
+  m_scanStepSwitch = 0;
+  m_scanRequest = 0;
+  m_scanRequestCount = 0;
+  m_scanAppliedCount = 0;
+
+  // last reports sent to host, kept across device reset so that releasing
+  // keys is reported when the IntelliKeys is unplugged
+  memset(&m_kbSentReport, 0, sizeof(m_kbSentReport));
+  m_mouseSentButtons = 0;
 
   tu_fifo_config(&_cmd_ff, _cmd_ff_buf, IK_CMD_FIFO_SIZE, 8, false);
   tu_fifo_config_mutex(&_cmd_ff, osal_mutex_create(&_cmd_ff_mutex), NULL);
 
+  tu_fifo_config(&_key_ff, _key_ff_buf, IK_KEYSTROKE_FIFO_SIZE, 4, false);
+  tu_fifo_config_mutex(&_key_ff, osal_mutex_create(&_key_ff_mutex), NULL);
+  m_typedCount = 0;
+  m_typingTime = 0;
+
+  memset(&m_kbPublished, 0, sizeof(m_kbPublished));
+  m_kbSeq = 0;
+  m_kbTakenSeq = 0;
+  m_macroSeq = 0;
+  m_bRebuilding = false;
+
+  m_settingsChangeCount = 0;
+  m_settingsChangeTime = 0;
+  m_settingsSavedCount = 0;
+  m_flashWriteTime = 0;
+
   //
 }
 
@@ -151,21 +210,47 @@ void Adafruit_IntelliKeys::Reset(void) {
   m_lastLEDTime = 0;
   m_delayUntil = 0;
   m_nextCorrect = 0;
+  m_correctInterval = IK_CORRECT_INTERVAL_MIN;
+  m_correctPending = false;
+  m_correcting = false;
 
   m_newLevel = 0;
   m_currentLevel = 0;
 
-  m_lastOverlay = -1;
-  m_lastOverlayTime = 0;
+  m_recognizer.reset();
+  m_recognizer.clearCalibration();
+  memset(m_sensorReadings, 0, sizeof(m_sensorReadings));
   m_currentOverlay = -1;
 
   m_toggle = -1;
 
   memset(m_membrane, 0, sizeof(m_membrane));
-  memset(m_last_membrane, 0, sizeof(m_last_membrane));
   memset(m_switches, 0, sizeof(m_switches));
 
+  m_touch.clear();
+  m_filter.clear();
+  ClearHIDReport();
+  m_scan.stop();
+  m_scanLed = 0;
+
+  m_keystrokeNext = 0;
+  m_keystrokeStart = 0;
+  memset(m_keystrokeHeld, 0, sizeof(m_keystrokeHeld));
+
+  m_macro.clear();
+  m_macroTime = 0;
+
+  m_unicodeLead = 0;
+
+  m_bShifted = false;
+  ClearTyped();
+  memset(m_smartKeys, 0, sizeof(m_smartKeys));
+
   m_bEepromValid = false;
+  m_bSerialChecked = false;
+  m_eepromDataValid = 0;
+  m_eepromInflight = 0;
+  memset(m_eepromRetry, 0, sizeof(m_eepromRetry));
 
   m_firmwareVersionMajor = 0;
   m_firmwareVersionMinor = 0;
@@ -175,6 +260,68 @@ void Adafruit_IntelliKeys::Reset(void) {
 
 void Adafruit_IntelliKeys::begin(void) { IKOverlay::initStandardOverlays(); }
 
+void Adafruit_IntelliKeys::setCustomOverlay(IKOverlay *overlay,
+                                            uint32_t count) {
+  // key mapping belongs to Periodic(), publish the request there
+  _custom_overlay_seq = _custom_overlay_seq + 1;
+  __sync_synchronize();
+  _custom_overlay_req = overlay;
+  _custom_overlay_req_count = count;
+  __sync_synchronize();
+  _custom_overlay_seq = _custom_overlay_seq + 1;
+}
+
+void Adafruit_IntelliKeys::ApplyCustomOverlay(void) {
+  uint32_t seq = _custom_overlay_seq;
+  if (seq == _custom_overlay_applied) {
+    return;
+  }
+
+  do {
+    seq = _custom_overlay_seq;
+    __sync_synchronize();
+    _custom_overlay = _custom_overlay_req;
+    _custom_overlay_count = _custom_overlay_req_count;
+    __sync_synchronize();
+  } while ((seq & 1) || seq != _custom_overlay_seq);
+
+  _custom_overlay_applied = seq;
+  RebuildHIDReport();
+  UpdateScan();
+}
+
+void Adafruit_IntelliKeys::setFlashVolume(FatVolume *vol) {
+  m_cache.begin(vol);
+
+  IKSettings *settings = IKSettings::GetSettings();
+  settings->SetVolume(vol);
+  settings->Read();
+}
+
+void Adafruit_IntelliKeys::saveChangedSettings(void) {
+  uint32_t const now = millis();
+  if (m_keycodeDown || now - m_flashWriteTime < IK_FLASH_WRITE_INTERVAL) {
+    return;
+  }
+
+  uint32_t const count = m_settingsChangeCount;
+  bool const settings = (count != m_settingsSavedCount &&
+                         now - m_settingsChangeTime >= IK_SETTINGS_SAVE_DELAY);
+  if (!settings && !m_cache.isDirty()) {
+    return;
+  }
+
+  // calibration of a newly verified board
+  m_cache.flush();
+
+  if (settings) {
+    m_settingsSavedCount = count;
+    IKSettings::GetSettings()->Write();
+  }
+
+  m_flashWriteTime = now;
+}
+
 bool Adafruit_IntelliKeys::mount(uint8_t daddr) {
   uint16_t vid, pid;
   tuh_vid_pid_get(daddr, &vid, &pid);
@@ -200,6 +347,12 @@ bool Adafruit_IntelliKeys::mount(uint8_t daddr) {
 
     // Start IK device
     Start();
+
+    // calibration of last used board until eeprom tells which one this is
+    eeprom_t eeprom;
+    if (m_cache.getRecent(&eeprom)) {
+      m_recognizer.setCalibration(&eeprom);
+    }
   } else {
     return false;
   }
@@ -210,17 +363,25 @@ bool Adafruit_IntelliKeys::mount(uint8_t daddr) {
 void Adafruit_IntelliKeys::umount(uint8_t daddr) {
   if (daddr == _daddr) {
     Reset();
+    tu_fifo_clear(&_key_ff); // not typed into the next board
   }
 }
 
 void Adafruit_IntelliKeys::Periodic(void) {
   if (!IsOpen()) {
-    return; // nothing to do
+    PublishKeyboardReport(); // released keys after unplug
+    return;                  // nothing to do
   }
 
   // settle overlay
   SettleOverlay();
 
+  ApplyScanSwitch();
+  ApplySwitchOverlays();
+  ApplyTouchMode();
+  ApplyMouseAccessTrackpad();
+  ApplyCustomOverlay();
+
   uint32_t now = millis();
 
   //  setLEDs
@@ -229,130 +390,697 @@ void Adafruit_IntelliKeys::Periodic(void) {
     m_lastLEDTime = now;
   }
 
-  //  request a correction every so often.
-  if (now > m_nextCorrect) {
+  //  request a correction every so often, next one is scheduled when it is
+  //  done or timed out
+  if ((int32_t)(now - m_nextCorrect) >= 0) {
     DoCorrect();
-    m_nextCorrect = now + 500;
+    m_correctPending = true;
+    m_nextCorrect = now + IK_CORRECT_TIMEOUT;
   }
 
   //  send for not-yet valid eeprom bytes
   if (!m_bEepromValid) {
-    for (uint8_t i = 0; i < sizeof(eeprom_t); i++) {
-      if (!m_eepromDataValid[i] && m_eepromRequestTime[i] + 500 < now) {
-        uint8_t report[8] = {
-            IK_CMD_EEPROM_READBYTE, (uint8_t)(0x80 + i), 0x1F, 0, 0, 0, 0, 0};
-        PostCommand(report);
-        m_eepromRequestTime[i] = now;
-      }
-    }
+    FetchEEProm(now);
   }
 
+  ProcessKeystrokes(now);
+  ProcessMacro(now);
   ProcessCommands();
 
-  // InterpretRaw();
-}
-
-static bool checkNewKeyboardReport(hid_keyboard_report_t const *report,
-                                   ik_report_keyboard_t *ik_keyboard) {
-  if (ik_keyboard->modifier != 0 &&
-      !(report->modifier & ik_keyboard->modifier)) {
-    return true;
+  uint16_t timer_id;
+  while (m_timer.poll(millis(), &timer_id)) {
+    OnTimer(timer_id);
   }
 
-  for (uint8_t i = 0; i < 6; i++) {
-    if (ik_keyboard->keycode == report->keycode[i]) {
-      return false;
+  PublishKeyboardReport();
+}
+
+void Adafruit_IntelliKeys::OnTimer(uint16_t id) {
+  if (id < IK_TIMER_REPEAT + IK_KEY_ID_COUNT) {
+    OnRepeatTimer((uint8_t)(id - IK_TIMER_REPEAT));
+  } else if (id < IK_TIMER_FILTER + IK_KEY_ID_COUNT) {
+    uint8_t const key_id = (uint8_t)(id - IK_TIMER_FILTER);
+    OnFilterResult(key_id, m_filter.timeout(key_id));
+  } else if (id == IK_TIMER_SCAN) {
+    if (m_scan.timeout(millis(), micros())) {
+      UpdateScanIndicator(true);
     }
+  } else if (id == IK_TIMER_SCAN_RELEASE) {
+    OutputKeyUp(m_scanKey);
+    m_scanKey = 0;
   }
+}
 
-  return true;
+static inline int8_t clampMouseDelta(int16_t delta) {
+  if (delta > 127) {
+    delta = 127;
+  } else if (delta < -127) {
+    delta = -127;
+  }
+  return (int8_t)delta;
 }
 
 static void combineMouseReport(hid_mouse_report_t *report,
                                ik_report_mouse_t *ik_mouse) {
-  report->buttons |= ik_mouse->buttons;
-  report->x += ik_mouse->x;
-  report->y += ik_mouse->y;
+  report->buttons |= ik_mouse->buttons & IK_REPORT_MOUSE_BUTTON_MASK;
+  report->x = clampMouseDelta(report->x + ik_mouse->x);
+  report->y = clampMouseDelta(report->y + ik_mouse->y);
+}
+
+// convert bitmap to boot report, keys beyond the first 6 are dropped
+static void nkroToBootReport(hid_keyboard_report_t *kb_report,
+                             ik_nkro_keyboard_report_t const *nkro_report) {
+  memset(kb_report, 0, sizeof(hid_keyboard_report_t));
+  kb_report->modifier = nkro_report->modifier;
+
+  uint8_t kb_count = 0;
+  for (uint8_t i = 0; i < sizeof(nkro_report->keybitmap) && kb_count < 6;
+       i++) {
+    uint8_t bits = nkro_report->keybitmap[i];
+    while (bits && kb_count < 6) {
+      uint8_t const b = __builtin_ctz(bits);
+      kb_report->keycode[kb_count++] = (uint8_t)(i * 8 + b);
+      bits &= (uint8_t)(bits - 1);
+    }
+  }
 }
 
 void Adafruit_IntelliKeys::getHIDReport(hid_keyboard_report_t *kb_report,
                                         hid_mouse_report_t *mouse_report) {
-  memset(kb_report, 0, sizeof(hid_keyboard_report_t));
+  ik_nkro_keyboard_report_t nkro_report;
+  getHIDReport(&nkro_report, mouse_report);
+  nkroToBootReport(kb_report, &nkro_report);
+}
+
+void Adafruit_IntelliKeys::getHIDReport(ik_nkro_keyboard_report_t *kb_report,
+                                        hid_mouse_report_t *mouse_report) {
+  BuildKeyboardReport(kb_report);
+  BuildMouseReport(mouse_report);
+}
+
+bool Adafruit_IntelliKeys::getKeyboardReport(hid_keyboard_report_t *report) {
+  ik_nkro_keyboard_report_t nkro_report;
+  bool const changed = getKeyboardReport(&nkro_report);
+  nkroToBootReport(report, &nkro_report);
+  return changed;
+}
+
+bool Adafruit_IntelliKeys::getKeyboardReport(
+    ik_nkro_keyboard_report_t *report) {
+  BuildKeyboardReport(report);
+
+  if (0 == memcmp(report, &m_kbSentReport, sizeof(m_kbSentReport))) {
+    return false;
+  }
+
+  m_kbSentReport = *report;
+  return true;
+}
+
+bool Adafruit_IntelliKeys::getMouseReport(hid_mouse_report_t *report) {
+  BuildMouseReport(report);
+
+  if (report->buttons == m_mouseSentButtons && report->x == 0 &&
+      report->y == 0) {
+    return false;
+  }
+
+  m_mouseSentButtons = report->buttons;
+  return true;
+}
+
+bool Adafruit_IntelliKeys::isReportReady(void) {
+  return IsOpen() && IsSwitchedOn();
+}
+
+// Report is maintained incrementally by KeyDown()/KeyUp() on membrane
+// press/release, here we only need to copy it and apply latched modifiers.
+// Called from the core running Periodic(), the copy is published with a
+// sequence counter so that the core sending reports never sees a torn one.
+void Adafruit_IntelliKeys::PublishKeyboardReport(void) {
+  ik_nkro_keyboard_report_t report;
+  memset(&report, 0, sizeof(report));
+
+  if (isReportReady()) {
+    report = m_kbReport;
+
+    // latched modifiers, they are lifted when the key typed with them is
+    // released (see ReleaseKey())
+    report.modifier |= m_modifiers.getHidModifier();
+  }
+
+  if (0 == memcmp(&report, &m_kbPublished, sizeof(report))) {
+    return;
+  }
+
+  m_kbSeq = m_kbSeq + 1;
+  __sync_synchronize();
+  m_kbPublished = report;
+  __sync_synchronize();
+  m_kbSeq = m_kbSeq + 1;
+}
+
+void Adafruit_IntelliKeys::BuildKeyboardReport(
+    ik_nkro_keyboard_report_t *kb_report) {
+  uint32_t seq;
+  do {
+    seq = m_kbSeq;
+    __sync_synchronize();
+    *kb_report = m_kbPublished;
+    __sync_synchronize();
+  } while ((seq & 1) || seq != m_kbSeq);
+
+  // tell macro playback that its last state is taken (after it is copied)
+  m_kbTakenSeq = seq;
+}
+
+void Adafruit_IntelliKeys::BuildMouseReport(hid_mouse_report_t *mouse_report) {
   memset(mouse_report, 0, sizeof(hid_mouse_report_t));
 
-  if (!IsOpen() || !IsSwitchedOn()) {
+  if (!isReportReady()) {
     return;
   }
 
+  for (uint8_t i = 0; i < 8; i++) {
+    if (m_mouseButtonCount[i]) {
+      mouse_report->buttons |= (uint8_t)(1u << i);
+    }
+  }
+
+  if (!(mouse_report->buttons & MOUSE_BUTTON_LEFT) &&
+      (m_modifiers.getState(IK_MOD_MOUSE_DOWN) != kModifierStateOff)) {
+    mouse_report->buttons |= MOUSE_BUTTON_LEFT;
+  }
+
+  // pointer motion from mouse keys and trackpad
+  ik_report_mouse_t motion = {0, 0, 0};
+  if (m_mouse.getMotion(millis(), &motion.x, &motion.y)) {
+    combineMouseReport(mouse_report, &motion);
+  }
+}
+
+bool Adafruit_IntelliKeys::getTrackpadAbsReport(ik_abs_mouse_report_t *report) {
+  report->buttons = 0;
+  for (uint8_t i = 0; i < 8; i++) {
+    if (m_mouseButtonCount[i]) {
+      report->buttons |= (uint8_t)(1u << i);
+    }
+  }
+  if (m_modifiers.getState(IK_MOD_MOUSE_DOWN) != kModifierStateOff) {
+    report->buttons |= MOUSE_BUTTON_LEFT;
+  }
+
+  report->x = m_tpAbsX;
+  report->y = m_tpAbsY;
+
+  return m_trackpadMode == IK_TRACKPAD_ABSOLUTE && m_tpTouching;
+}
+
+void Adafruit_IntelliKeys::UpdateKeyReport(ik_report_t const *report,
+                                           bool down) {
+  int8_t const delta = down ? 1 : -1;
+
+  if (report->type == IK_REPORT_TYPE_KEYBOARD) {
+    uint8_t const modifier = report->keyboard.modifier;
+    for (uint8_t i = 0; i < 8; i++) {
+      if (modifier & (1u << i)) {
+        m_modifierCount[i] += delta;
+        if (m_modifierCount[i]) {
+          m_kbReport.modifier |= (uint8_t)(1u << i);
+        } else {
+          m_kbReport.modifier &= (uint8_t)~(1u << i);
+        }
+      }
+    }
+
+    uint8_t const keycode = report->keyboard.keycode;
+    if (keycode != 0 && keycode < IK_NKRO_KEYCODE_COUNT) {
+      uint8_t const mask = (uint8_t)(1u << (keycode % 8));
+      if (down && m_keycodeCount[keycode]++ == 0) {
+        m_kbReport.keybitmap[keycode / 8] |= mask;
+        m_keycodeDown++;
+      } else if (!down && --m_keycodeCount[keycode] == 0) {
+        m_kbReport.keybitmap[keycode / 8] &= (uint8_t)~mask;
+        m_keycodeDown--;
+
+        // typed key is released: latched modifiers are done with
+        m_modifiers.update(IK_MOD_KEYBOARD_MASK, IK_MOD_EVENT_KEY,
+                           IKSettings::GetSettings()->m_iShiftKeyAction,
+                           millis());
+      }
+    }
+  } else if (report->type == IK_REPORT_TYPE_MOUSE) {
+    // double click, click hold and trackpad are not HID buttons
+    uint8_t const buttons =
+        report->mouse.buttons & IK_REPORT_MOUSE_BUTTON_MASK;
+    for (uint8_t i = 0; i < 8; i++) {
+      if (buttons & (1u << i)) {
+        m_mouseButtonCount[i] += delta;
+      }
+    }
+
+    if (report->mouse.x || report->mouse.y) {
+      m_mouseX += delta * report->mouse.x;
+      m_mouseY += delta * report->mouse.y;
+
+      // opposite keys cancel out
+      int8_t const dir_x = (m_mouseX > 0) - (m_mouseX < 0);
+      int8_t const dir_y = (m_mouseY > 0) - (m_mouseY < 0);
+      m_mouse.setDirection(dir_x, dir_y);
+    }
+  }
+}
+
+// m_repeatFlags
+enum {
+  REPEAT_ACTIVE = (1u << 0),  // repeat timer is running
+  REPEAT_BREAK = (1u << 1),   // keycode is released between repeats
+  REPEAT_FIRED = (1u << 2),   // repeated at least once
+  REPEAT_LATCHED = (1u << 3), // lifted off but kept repeating
+};
+
+// Report of overlay key or switch, NULL if there is no overlay for it
+ik_report_t const *Adafruit_IntelliKeys::GetKeyReport(uint8_t key_id) {
   IKOverlay *overlay = GetCurrentOverlay();
-  if (overlay == NULL) {
+
+  if (key_id >= IK_SWITCH_KEY_ID(0)) {
+    uint8_t const nswitch = (uint8_t)(key_id - IK_SWITCH_KEY_ID(0));
+    if (overlay) {
+      ik_report_t const *report = overlay->getSwitchKeyReport(nswitch);
+      if (report->type != IK_REPORT_TYPE_NONE) {
+        return report;
+      }
+    }
+    return &m_switchOverlays[m_switchOverlay].switches[nswitch];
+  }
+
+  return overlay ? overlay->getKeyReport(key_id) : NULL;
+}
+
+// Modifier and latching keys are held while other keys are typed
+static bool isChordKey(ik_report_t const *report) {
+  if (report->type == IK_REPORT_TYPE_KEYBOARD) {
+    return report->keyboard.keycode == 0 && report->keyboard.modifier != 0;
+  }
+  return report->type == IK_REPORT_TYPE_MOUSE &&
+         (report->mouse.buttons & IK_REPORT_MOUSE_CLICK_HOLD);
+}
+
+void Adafruit_IntelliKeys::KeyDown(uint8_t key_id) {
+  ik_report_t const *report = GetKeyReport(key_id);
+  if (key_id == 0 || report == NULL) {
     return;
   }
 
-  uint8_t kb_count = 0;
+  if (m_keyCellCount[key_id]++ == 0) {
+    uint8_t result = m_filter.press(key_id, millis(), isChordKey(report));
+    if (m_bRebuilding && m_filter.isDown(key_id)) {
+      // accepted before rebuild: only its report is restored
+      result = IK_FILTER_PRESS;
+    }
+    OnFilterResult(key_id, result);
+  }
+}
 
-  //------------- scan membrane -------------//
-  for (uint8_t i = 0; i < IK_RESOLUTION_X; i++) {
-    for (uint8_t j = 0; j < IK_RESOLUTION_Y; j++) {
-      if (m_membrane[i][j] == 1) {
-        ik_report_t ik_report;
-        overlay->getMembraneReport(i, j, &ik_report);
-
-        if (ik_report.type == IK_REPORT_TYPE_KEYBOARD) {
-          // Serial.printf(
-          //    "rol = %u, col = %u, modifier = %02X, keycode = %02X\r\n", i, j,
-          //    ik_report.keyboard.modifier, ik_report.keyboard.keycode);
-          if (checkNewKeyboardReport(kb_report, &ik_report.keyboard)) {
-            kb_report->modifier |= ik_report.keyboard.modifier;
-            if (ik_report.keyboard.keycode != 0) {
-              kb_report->keycode[kb_count] = ik_report.keyboard.keycode;
-              kb_count++;
-              if (kb_count >= 6) {
-                break;
-              }
-            }
-          }
-        } else if (ik_report.type == IK_REPORT_TYPE_MOUSE) {
-          //          Serial.printf(
-          //              "rol = %u, col = %u, buttons = %02X, x = %d, y =
-          //              %d\r\n", i, j, ik_report.mouse.buttons,
-          //              ik_report.mouse.x, ik_report.mouse.y);
-          combineMouseReport(mouse_report, &ik_report.mouse);
+void Adafruit_IntelliKeys::KeyUp(uint8_t key_id) {
+  if (key_id == 0 || m_keyCellCount[key_id] == 0 ||
+      GetKeyReport(key_id) == NULL) {
+    return;
+  }
+
+  if (--m_keyCellCount[key_id] == 0) {
+    OnFilterResult(key_id, m_filter.release(key_id, millis()));
+  }
+}
+
+void Adafruit_IntelliKeys::OnFilterResult(uint8_t key_id, uint8_t result) {
+  if (GetKeyReport(key_id) == NULL) {
+    return;
+  }
+
+  if (result == IK_FILTER_PRESS) {
+    OutputKeyDown(key_id);
+  } else if (result == IK_FILTER_RELEASE) {
+    OutputKeyUp(key_id);
+  }
+}
+
+// Key accepted by input filter
+void Adafruit_IntelliKeys::OutputKeyDown(uint8_t key_id) {
+  // pressing any key stops latched repeat
+  StopLatchedRepeat();
+
+  ik_report_t const *report = GetKeyReport(key_id);
+  if (report->type == IK_REPORT_TYPE_MACRO ||
+      report->type == IK_REPORT_TYPE_UNICODE ||
+      report->type == IK_REPORT_TYPE_SMART_TYPING ||
+      report->type == IK_REPORT_TYPE_PREDICT) {
+    // typed once per press, not again when report is rebuilt
+    if (!m_bRebuilding) {
+      if (report->type == IK_REPORT_TYPE_MACRO) {
+        // macro text is not followed by smart typing, it counts as one key
+        // of unknown class so that rules do not fire on what it ends with
+        m_macro.play(report->macro.index);
+        RecordTyped(0, false);
+      } else if (report->type == IK_REPORT_TYPE_UNICODE) {
+        PostUnicode(report->unicode.code_point);
+      } else if (report->type == IK_REPORT_TYPE_PREDICT) {
+        PostPrediction(report->predict.index);
+      } else {
+        setSmartTyping(!IKSettings::GetSettings()->m_bSmartTyping);
+      }
+    }
+    return;
+  }
+
+  uint32_t const smart_mask = 1ul << (key_id % 32);
+  if (m_bRebuilding) {
+    // already typed by smart typing
+    if (m_smartKeys[key_id / 32] & smart_mask) {
+      return;
+    }
+  } else {
+    m_smartKeys[key_id / 32] &= ~smart_mask;
+
+    if (report->type == IK_REPORT_TYPE_KEYBOARD) {
+      if (SmartTypeKey(&report->keyboard)) {
+        m_smartKeys[key_id / 32] |= smart_mask;
+        return;
+      }
+    } else if (report->type == IK_REPORT_TYPE_MOUSE &&
+               (report->mouse.buttons & (IK_REPORT_MOUSE_BUTTON_MASK |
+                                         IK_REPORT_MOUSE_DOUBLE_CLICK))) {
+      // click may move the text cursor
+      ClearTyped();
+    }
+  }
+
+  UpdateKeyReport(report, true);
+  StartRepeat(key_id);
+}
+
+void Adafruit_IntelliKeys::OutputKeyUp(uint8_t key_id) {
+  uint32_t const smart_mask = 1ul << (key_id % 32);
+  if (m_smartKeys[key_id / 32] & smart_mask) {
+    // key was typed (pressed and released) on key down
+    m_smartKeys[key_id / 32] &= ~smart_mask;
+    return;
+  }
+
+  uint8_t const flags = m_repeatFlags[key_id];
+  IKSettings *settings = IKSettings::GetSettings();
+  if ((flags & REPEAT_FIRED) && settings->m_bRepeat &&
+      settings->m_bRepeatLatching) {
+    // key that already repeats keeps repeating after lift off
+    m_repeatFlags[key_id] |= REPEAT_LATCHED;
+    m_repeatLatchCount++;
+    return;
+  }
+
+  ReleaseKey(key_id);
+}
+
+//--------------------------------------------------------------------+
+// Key Repeat
+//--------------------------------------------------------------------+
+
+static uint32_t repeatInterval(void) {
+  int rate = IKSettings::GetSettings()->m_iRepeatRate;
+  if (rate < kSettingsRateLow) {
+    rate = kSettingsRateLow;
+  } else if (rate > kSettingsRateHigh) {
+    rate = kSettingsRateHigh;
+  }
+
+  return IK_REPEAT_INTERVAL_SLOW -
+         (uint32_t)(rate - kSettingsRateLow) *
+             (IK_REPEAT_INTERVAL_SLOW - IK_REPEAT_INTERVAL_FAST) /
+             (kSettingsRateHigh - kSettingsRateLow);
+}
+
+// Only keys with a non-modifier keycode are repeated
+static bool isRepeatable(ik_report_t const *report) {
+  return report->type == IK_REPORT_TYPE_KEYBOARD &&
+         report->keyboard.keycode != 0 &&
+         report->keyboard.keycode < IK_NKRO_KEYCODE_COUNT;
+}
+
+// Release key output, keycode is already up if released in repeat break
+void Adafruit_IntelliKeys::ReleaseKey(uint8_t key_id) {
+  ik_report_t report = *GetKeyReport(key_id);
+
+  uint8_t const flags = m_repeatFlags[key_id];
+  if (flags) {
+    m_timer.cancel(IK_TIMER_REPEAT + key_id);
+    if (flags & REPEAT_BREAK) {
+      report.keyboard.keycode = 0;
+    }
+    if (flags & REPEAT_LATCHED) {
+      m_repeatLatchCount--;
+    }
+    m_repeatFlags[key_id] = 0;
+  }
+
+  UpdateKeyReport(&report, false);
+}
+
+// With system repeat settings, host OS repeats the held key. Otherwise we
+// repeat it by releasing and pressing its keycode or, with repeat off, release
+// the keycode shortly after press so that host does not repeat it.
+void Adafruit_IntelliKeys::StartRepeat(uint8_t key_id) {
+  IKSettings *settings = IKSettings::GetSettings();
+  if (settings->m_bUseSystemRepeatSettings ||
+      !isRepeatable(GetKeyReport(key_id))) {
+    return;
+  }
+
+  uint32_t const now = millis();
+  uint32_t delay = IK_REPEAT_BREAK_TIME;
+  if (settings->m_bRepeat) {
+    uint32_t const interval = repeatInterval();
+    delay = (interval > IK_REPEAT_DELAY) ? interval : IK_REPEAT_DELAY;
+  }
+
+  m_repeatFlags[key_id] = REPEAT_ACTIVE;
+  m_timer.start(IK_TIMER_REPEAT + key_id, now + delay);
+}
+
+void Adafruit_IntelliKeys::StopLatchedRepeat(void) {
+  if (m_repeatLatchCount == 0) {
+    return;
+  }
+
+  for (uint16_t id = 1; id < IK_KEY_ID_COUNT && m_repeatLatchCount; id++) {
+    if (m_repeatFlags[id] & REPEAT_LATCHED) {
+      ReleaseKey((uint8_t)id);
+    }
+  }
+}
+
+void Adafruit_IntelliKeys::OnRepeatTimer(uint8_t key_id) {
+  ik_report_t const *key_report = GetKeyReport(key_id);
+  if (key_report == NULL || !(m_repeatFlags[key_id] & REPEAT_ACTIVE)) {
+    return;
+  }
+
+  // toggle keycode only, modifiers of the key stay down
+  ik_report_t report;
+  report.type = IK_REPORT_TYPE_KEYBOARD;
+  report.keyboard.modifier = 0;
+  report.keyboard.keycode = key_report->keyboard.keycode;
+  uint32_t const now = millis();
+
+  if (m_repeatFlags[key_id] & REPEAT_BREAK) {
+    // end of break: press again, next repeat is one interval after previous
+    m_repeatFlags[key_id] &= (uint8_t)~REPEAT_BREAK;
+    UpdateKeyReport(&report, true);
+    m_timer.start(IK_TIMER_REPEAT + key_id,
+                  now + repeatInterval() - IK_REPEAT_BREAK_TIME);
+  } else if (IKSettings::GetSettings()->m_bRepeat) {
+    m_repeatFlags[key_id] |= REPEAT_BREAK | REPEAT_FIRED;
+    UpdateKeyReport(&report, false);
+    // repeated keys (e.g backspace) leave unknown text behind
+    ClearTyped();
+    m_timer.start(IK_TIMER_REPEAT + key_id, now + IK_REPEAT_BREAK_TIME);
+  } else {
+    // repeat off: keycode is released once so that host does not repeat it,
+    // the key has not repeated and is not latched on lift off
+    m_repeatFlags[key_id] = REPEAT_BREAK;
+    UpdateKeyReport(&report, false);
+  }
+}
+
+void Adafruit_IntelliKeys::ClearHIDReport(void) {
+  for (uint16_t id = 0; id < IK_KEY_ID_COUNT; id++) {
+    if (m_repeatFlags[id]) {
+      m_timer.cancel(IK_TIMER_REPEAT + id);
+    }
+  }
+  memset(m_repeatFlags, 0, sizeof(m_repeatFlags));
+  m_repeatLatchCount = 0;
+  m_timer.cancel(IK_TIMER_SCAN_RELEASE);
+  m_scanKey = 0;
+
+  memset(m_keyCellCount, 0, sizeof(m_keyCellCount));
+  memset(m_keycodeCount, 0, sizeof(m_keycodeCount));
+  memset(m_modifierCount, 0, sizeof(m_modifierCount));
+  memset(m_mouseButtonCount, 0, sizeof(m_mouseButtonCount));
+  m_mouseX = m_mouseY = 0;
+  m_mouse.reset();
+  m_keycodeDown = 0;
+  memset(&m_kbReport, 0, sizeof(m_kbReport));
+  m_touchKeyCount = 0;
+
+  m_tpTouching = false;
+}
+
+// Recompute all key counts from current membrane and switches, used when the
+// overlay (key mapping), switch overlay or touch mode is changed.
+void Adafruit_IntelliKeys::RebuildHIDReport(void) {
+  ClearHIDReport();
+  m_bRebuilding = true;
+
+  // keys put down by keystroke queue and macro playback
+  for (uint16_t code = 0; code < 256; code++) {
+    if (m_keystrokeHeld[code / 32] & (1ul << (code % 32))) {
+      ik_report_t report;
+      report.type = IK_REPORT_TYPE_KEYBOARD;
+      ik_universal_to_keyboard((uint8_t)code, &report.keyboard);
+      UpdateKeyReport(&report, true);
+    }
+  }
+
+  ik_report_t macro_key;
+  macro_key.type = IK_REPORT_TYPE_KEYBOARD;
+  if (m_macro.getHeldKey(&macro_key.keyboard)) {
+    UpdateKeyReport(&macro_key, true);
+  }
+
+  for (uint8_t i = 0; i < IK_NUM_SWITCHES; i++) {
+    if (m_switches[i] && !IsScanSwitch(i + 1)) {
+      KeyDown(IK_SWITCH_KEY_ID(i));
+    }
+  }
+
+  IKOverlay *overlay = GetCurrentOverlay();
+  if (overlay) {
+    for (uint8_t row = 0; row < IK_RESOLUTION_Y; row++) {
+      for (uint8_t col = 0; col < IK_RESOLUTION_X; col++) {
+        m_touch.setCell(row, col, m_membrane[row][col]);
+        if (m_membrane[row][col] && !m_touchMode) {
+          KeyDown(overlay->getKeyId(row, col));
         }
       }
     }
+
+    UpdateTouches();
   }
 
-  // Check for modifier latching
-  if (m_modShift.GetState() != kModifierStateOff) {
-    kb_report->modifier |= KEYBOARD_MODIFIER_LEFTSHIFT;
+  // input filter state is kept for held keys, so that a key still waiting
+  // for its dwell time is not output twice
+  for (uint16_t id = 1; id < IK_KEY_ID_COUNT; id++) {
+    if (m_keyCellCount[id] == 0) {
+      m_filter.drop((uint8_t)id);
+      m_smartKeys[id / 32] &= ~(1ul << (id % 32));
+    }
   }
 
-  if (m_modAlt.GetState() != kModifierStateOff) {
-    kb_report->modifier |= KEYBOARD_MODIFIER_LEFTALT;
+  m_bRebuilding = false;
+}
+
+// Re-compute touches (blobs) for touch mode and trackpad
+void Adafruit_IntelliKeys::UpdateTouches(void) {
+  IKOverlay *overlay = GetCurrentOverlay();
+  if (overlay == NULL) {
+    return;
   }
 
-  if (m_modControl.GetState() != kModifierStateOff) {
-    kb_report->modifier |= KEYBOARD_MODIFIER_LEFTCTRL;
+  if (!m_touchMode && !overlay->hasTrackpad()) {
+    return;
   }
 
-  if (m_modCommand.GetState() != kModifierStateOff) {
-    kb_report->modifier |= KEYBOARD_MODIFIER_LEFTGUI;
+  uint8_t const count = m_touch.update(overlay);
+
+  if (m_touchMode) {
+    UpdateTouchKeys(count);
   }
 
-  if (kb_count) {
-    PostLiftAllModifiers();
+  if (overlay->hasTrackpad()) {
+    UpdateTrackpad(overlay);
   }
+}
 
-  if (!(mouse_report->buttons & MOUSE_BUTTON_LEFT) &&
-      (m_mouseDown.GetState() != kModifierStateOff)) {
-    mouse_report->buttons |= MOUSE_BUTTON_LEFT;
+// Press the nearest key of each touch. New keys are pressed before old ones
+// are released so that a key held by a moving touch does not bounce.
+void Adafruit_IntelliKeys::UpdateTouchKeys(uint8_t count) {
+  uint8_t old_keys[IK_TOUCH_MAX];
+  uint8_t const old_count = m_touchKeyCount;
+  memcpy(old_keys, m_touchKeys, old_count);
+
+  for (uint8_t i = 0; i < count; i++) {
+    m_touchKeys[i] = m_touch.getTouch(i)->key_id;
+    KeyDown(m_touchKeys[i]);
   }
+  m_touchKeyCount = count;
 
-  // TODO scan switch
+  for (uint8_t i = 0; i < old_count; i++) {
+    KeyUp(old_keys[i]);
+  }
 }
 
-void Adafruit_IntelliKeys::InterpretRaw() {
+// Pointer follows the first touch landing on the trackpad region. Relative
+// mode moves by the centroid delta (sub-cell resolution) with a gain that
+// increases with touch speed. Absolute mode maps centroid position within the
+// region to the full pointer range.
+void Adafruit_IntelliKeys::UpdateTrackpad(IKOverlay *overlay) {
+  ik_touch_t const *touch = NULL;
+  for (uint8_t i = 0; i < m_touch.getCount(); i++) {
+    if (overlay->isTrackpadKey(m_touch.getTouch(i)->key_id)) {
+      touch = m_touch.getTouch(i);
+      break;
+    }
+  }
+
+  if (touch == NULL) {
+    m_tpTouching = false;
+    return;
+  }
+
+  if (m_trackpadMode == IK_TRACKPAD_ABSOLUTE) {
+    uint8_t row, col, height, width;
+    overlay->getTrackpad(&row, &col, &height, &width);
+
+    // centroid can be slightly outside of region if it is the nearest key
+    int32_t x = touch->x - (col << IK_TOUCH_FRAC_BITS);
+    int32_t y = touch->y - (row << IK_TOUCH_FRAC_BITS);
+    x = (x < 0) ? 0 : tu_min32(x, (width << IK_TOUCH_FRAC_BITS) - 1);
+    y = (y < 0) ? 0 : tu_min32(y, (height << IK_TOUCH_FRAC_BITS) - 1);
+
+    m_tpAbsX = (uint16_t)(x * IK_ABS_MOUSE_MAX / (width << IK_TOUCH_FRAC_BITS));
+    m_tpAbsY =
+        (uint16_t)(y * IK_ABS_MOUSE_MAX / (height << IK_TOUCH_FRAC_BITS));
+  } else if (m_tpTouching) {
+    int32_t const dx = (int32_t)touch->x - m_tpLastX;
+    int32_t const dy = (int32_t)touch->y - m_tpLastY;
+
+    // pixels per cell in 1/256, increased by speed (motion per update)
+    int32_t const speed = (abs(dx) > abs(dy)) ? abs(dx) : abs(dy);
+    int32_t const gain =
+        IK_TRACKPAD_GAIN * (256 + speed * IK_TRACKPAD_ACCEL / 256);
+
+    m_mouse.addMotion(dx * gain / 256, dy * gain / 256);
+  }
+
+  m_tpLastX = touch->x;
+  m_tpLastY = touch->y;
+  m_tpTouching = true;
+}
+
+// Interpret a membrane cell change: key sound, modifier latching and user
+// callback. Called for each press/release event including ones synthesized by
+// correction.
+void Adafruit_IntelliKeys::InterpretMembrane(uint8_t row, uint8_t col,
+                                             uint8_t state) {
   //  don't bother if we're not connected and switched on
   if (!IsOpen()) {
     return;
@@ -361,69 +1089,77 @@ void Adafruit_IntelliKeys::InterpretRaw() {
     return;
   }
 
-  IKOverlay *overlay = GetCurrentOverlay();
+  IK_PRINTF("membrane [%02u, %02u] = %u\r\n", row, col, state);
 
-  //  look for _membrane change
-  for (uint8_t col = 0; col < IK_RESOLUTION_X; col++) {
-    for (uint8_t row = 0; row < IK_RESOLUTION_Y; row++) {
-      const uint8_t state = m_membrane[row][col];
-      if (state != m_last_membrane[row][col]) {
-        IK_PRINTF("membrane [%02u, %02u] = %u\r\n", row, col, state);
-
-        if (state) {
-          ShortKeySound();
-
-          // Modifier Latching
-          if (overlay) {
-            ik_report_t ik_report;
-            overlay->getMembraneReport(row, col, &ik_report);
-
-            if (ik_report.type == IK_REPORT_TYPE_KEYBOARD) {
-              uint8_t const modifier = ik_report.keyboard.modifier;
-
-              m_modControl.UpdateState(modifier);
-              m_modShift.UpdateState(modifier);
-              m_modAlt.UpdateState(modifier);
-              m_modCommand.UpdateState(modifier);
-            } else if (ik_report.type == IK_REPORT_TYPE_MOUSE) {
-              if (ik_report.mouse.buttons & IK_REPORT_MOUSE_CLICK_HOLD) {
-                m_mouseDown.ToggleState();
-              }
-
-              if (ik_report.mouse.buttons &
-                  (MOUSE_BUTTON_LEFT | IK_REPORT_MOUSE_DOUBLE_CLICK)) {
-                m_mouseDown.SetState(kModifierStateOff);
-              }
-            }
-          }
-        }
+  if (state) {
+    if (!m_correcting) {
+      ShortKeySound();
+    }
 
-        // save current state for next time
-        m_last_membrane[row][col] = state;
+    IKOverlay *overlay = GetCurrentOverlay();
+    if (overlay) {
+      InterpretReport(overlay->getKeyReport(overlay->getKeyId(row, col)));
+    }
+  }
 
-        if (_membrane_cb) {
-          _membrane_cb(row, col, state);
-        }
-      }
+  if (_membrane_cb) {
+    _membrane_cb(row, col, state);
+  }
+}
+
+// Modifier latching and click hold of a pressed key
+void Adafruit_IntelliKeys::InterpretReport(ik_report_t const *report) {
+  uint32_t const now = millis();
+
+  if (report->type == IK_REPORT_TYPE_KEYBOARD) {
+    uint8_t const mods = IKModifiers::fromHid(report->keyboard.modifier);
+    if (mods) {
+      m_modifiers.update(mods, IK_MOD_EVENT_PRESS,
+                         IKSettings::GetSettings()->m_iShiftKeyAction, now);
+    }
+  } else if (report->type == IK_REPORT_TYPE_MOUSE) {
+    uint8_t const mouse_down = (1u << IK_MOD_MOUSE_DOWN);
+
+    // click hold toggles
+    if (report->mouse.buttons & IK_REPORT_MOUSE_CLICK_HOLD) {
+      m_modifiers.update(mouse_down, IK_MOD_EVENT_PRESS,
+                         kSettingsShiftLatching, now);
+    }
+
+    if (report->mouse.buttons &
+        (MOUSE_BUTTON_LEFT | IK_REPORT_MOUSE_DOUBLE_CLICK)) {
+      m_modifiers.update(mouse_down, IK_MOD_EVENT_CLEAR,
+                         kSettingsShiftLatching, now);
     }
   }
+}
 
-  //  look for switch change
-  for (uint8_t nsw = 0; nsw < IK_NUM_SWITCHES; nsw++) {
-    if (m_switches[nsw] != m_last_switches[nsw]) {
-      IK_PRINTF("switch %02u = %u\r\n", nsw, m_switches[nsw]);
-      if (m_switches[nsw]) {
-        ShortKeySound();
-      }
+// Deprecated: membrane and switch changes are interpreted as each event
+// arrives (InterpretMembrane/InterpretSwitch), nothing is left to scan here.
+// Kept so that existing sketches still build.
+void Adafruit_IntelliKeys::InterpretRaw(void) {}
 
-      // save current state for next time
-      m_last_switches[nsw] = m_switches[nsw];
+void Adafruit_IntelliKeys::InterpretSwitch(uint8_t nsw, uint8_t state) {
+  if (!IsOpen()) {
+    return;
+  }
+  if (!IsSwitchedOn()) {
+    return;
+  }
 
-      if (_switch_cb) {
-        _switch_cb(nsw, m_switches[nsw]);
-      }
+  IK_PRINTF("switch %02u = %u\r\n", nsw, state);
+  if (state) {
+    if (!m_correcting) {
+      ShortKeySound();
+    }
+    if (!IsScanSwitch(nsw + 1)) {
+      InterpretReport(GetKeyReport(IK_SWITCH_KEY_ID(nsw)));
     }
   }
+
+  if (_switch_cb) {
+    _switch_cb(nsw, state);
+  }
 }
 
 //--------------------------------------------------------------------+
@@ -474,53 +1210,150 @@ bool Adafruit_IntelliKeys::IsCapsLockOn(void) {
 }
 
 bool Adafruit_IntelliKeys::IsMouseDown(void) {
-  return m_mouseDown.GetState() != 0;
+  return m_modifiers.getState(IK_MOD_MOUSE_DOWN) != kModifierStateOff;
 }
 
 void Adafruit_IntelliKeys::DoCorrect(void) {
   //  clear out data
-  for (int i = 0; i < IK_NUM_SWITCHES; i++) {
-    m_switchesPressedInCorrectMode[i] = 0;
+  m_switchesPressedInCorrectMode = 0;
+  memset(m_membranePressedInCorrectMode, 0,
+         sizeof(m_membranePressedInCorrectMode));
+
+  //  send the command
+  uint8_t report[IK_REPORT_LEN] = {IK_CMD_CORRECT, 0, 0, 0, 0, 0, 0, 0};
+  PostCommand(report);
+}
+
+// Make sure next correction is no later than interval from now
+void Adafruit_IntelliKeys::ScheduleCorrect(uint32_t interval) {
+  if (m_correctInterval > interval) {
+    m_correctInterval = interval;
   }
 
-  for (int x = 0; x < IK_RESOLUTION_X; x++) {
-    for (int y = 0; y < IK_RESOLUTION_Y; y++) {
-      m_membranePressedInCorrectMode[y][x] = 0;
+  if (!m_correctPending) {
+    uint32_t const next = millis() + interval;
+    if ((int32_t)(m_nextCorrect - next) > 0) {
+      m_nextCorrect = next;
     }
   }
+}
 
-  //  send the command
-  uint8_t report[IK_REPORT_LEN] = {IK_CMD_CORRECT, 0, 0, 0, 0, 0, 0, 0};
-  PostCommand(report);
+// Input events are probably lost (e.g duplicated press/release)
+void Adafruit_IntelliKeys::SuspectEventLoss(void) {
+  IK_PRINTF("Event loss suspected, correct soon\r\n");
+  ScheduleCorrect(IK_CORRECT_INTERVAL_MIN);
 }
 
 void Adafruit_IntelliKeys::OnCorrectMembrane(int x, int y) {
-  m_membranePressedInCorrectMode[y][x] = true;
+  if (x < IK_RESOLUTION_X && y < IK_RESOLUTION_Y) {
+    m_membranePressedInCorrectMode[y] |= (1ul << x);
+  }
 }
 
-void Adafruit_IntelliKeys::OnCorrectSwitch(int switchnum) {
-  int ns = switchnum;
-  m_switchesPressedInCorrectMode[ns - 1] = true;
-}
+void Adafruit_IntelliKeys::OnCorrectSwitch(int switchnum) {
+  if (switchnum >= 1 && switchnum <= IK_NUM_SWITCHES) {
+    m_switchesPressedInCorrectMode |= (uint8_t)(1u << (switchnum - 1));
+  }
+}
+
+// Reconcile with correction snapshot: only differences are applied as
+// press/release events so that key output, touches and callbacks follow the
+// same path as normal events.
+void Adafruit_IntelliKeys::OnCorrectDone() {
+  bool consistent = true;
+
+  // synthetic presses are not user actions, don't click for them
+  m_correcting = true;
+
+  uint32_t const *rows = m_touch.getRows(); // current membrane as bitset
+  for (uint8_t row = 0; row < IK_RESOLUTION_Y; row++) {
+    uint32_t const pressed = m_membranePressedInCorrectMode[row];
+    uint32_t diff = rows[row] ^ pressed;
+
+    while (diff) {
+      uint8_t const col = (uint8_t)__builtin_ctz(diff);
+      diff &= diff - 1;
+      consistent = false;
+
+      IK_PRINTF("Correct membrane [%02u, %02u]\r\n", row, col);
+      if (pressed & (1ul << col)) {
+        OnMembranePress(col, row);
+      } else {
+        OnMembraneRelease(col, row);
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < IK_NUM_SWITCHES; i++) {
+    uint8_t const state = (m_switchesPressedInCorrectMode >> i) & 1u;
+    if (m_switches[i] != state) {
+      consistent = false;
+      OnSwitch(i + 1, state);
+    }
+  }
+  m_correcting = false;
 
-void Adafruit_IntelliKeys::OnCorrectDone() {
-  for (int i = 0; i < IK_NUM_SWITCHES; i++) {
-    m_switches[i] = m_switchesPressedInCorrectMode[i];
+  // adapt correction interval
+  bool idle = true;
+  for (uint8_t row = 0; row < IK_RESOLUTION_Y && idle; row++) {
+    idle = (rows[row] == 0);
+  }
+  for (uint8_t i = 0; i < IK_NUM_SWITCHES && idle; i++) {
+    idle = (m_switches[i] == 0);
   }
 
-  for (int x = 0; x < IK_RESOLUTION_X; x++) {
-    for (int y = 0; y < IK_RESOLUTION_Y; y++) {
-      m_membrane[y][x] = m_membranePressedInCorrectMode[y][x];
+  if (!consistent) {
+    m_correctInterval = IK_CORRECT_INTERVAL_MIN;
+  } else if (!idle) {
+    m_correctInterval = IK_CORRECT_INTERVAL_HELD;
+  } else if (m_correctInterval < IK_CORRECT_INTERVAL_MAX) {
+    m_correctInterval *= 2;
+    if (m_correctInterval > IK_CORRECT_INTERVAL_MAX) {
+      m_correctInterval = IK_CORRECT_INTERVAL_MAX;
     }
   }
+
+  m_correctPending = false;
+  m_nextCorrect = millis() + m_correctInterval;
 }
 
 void Adafruit_IntelliKeys::OnMembranePress(int x, int y) {
+  if (m_membrane[y][x]) {
+    // missed release
+    SuspectEventLoss();
+    return;
+  }
   m_membrane[y][x] = 1;
+
+  // key is held, watch for missed release
+  ScheduleCorrect(IK_CORRECT_INTERVAL_HELD);
+  m_touch.setCell(y, x, true);
+
+  IKOverlay *overlay = GetCurrentOverlay();
+  if (overlay && !m_touchMode) {
+    KeyDown(overlay->getKeyId(y, x));
+  }
+
+  UpdateTouches();
+  InterpretMembrane(y, x, 1);
 }
 
 void Adafruit_IntelliKeys::OnMembraneRelease(int x, int y) {
+  if (!m_membrane[y][x]) {
+    // missed press
+    SuspectEventLoss();
+    return;
+  }
   m_membrane[y][x] = 0;
+  m_touch.setCell(y, x, false);
+
+  IKOverlay *overlay = GetCurrentOverlay();
+  if (overlay && !m_touchMode) {
+    KeyUp(overlay->getKeyId(y, x));
+  }
+
+  UpdateTouches();
+  InterpretMembrane(y, x, 0);
 }
 
 // All commands processed in this function is sent to device
@@ -568,10 +1401,11 @@ bool Adafruit_IntelliKeys::PostCommand(uint8_t *command) {
     }
     // IK_PRINTF("PostCommand: %s\r\n", ik_cmd_str[cmd_id]);
 
-    // queue command sent to device
+    // queue command sent to device, full queue is back-pressure: caller may
+    // try again later (e.g correction is re-sent after IK_CORRECT_TIMEOUT)
     if (!tu_fifo_write(&_cmd_ff, command)) {
-      IK_PRINTF("PostCommand: Failed to queue command, probably full. Please "
-                "increase IK_CMD_FIFO_SIZE\n");
+      IK_PRINTF("PostCommand: command queue is full\r\n");
+      return false;
     }
   } else {
     // local driver command
@@ -587,6 +1421,35 @@ bool Adafruit_IntelliKeys::PostCommand(uint8_t *command) {
         m_delayUntil = millis() + command[1];
         break;
 
+      case IK_CMD_KEYBOARD:
+        if (!tu_fifo_write(&_key_ff, &command[1])) {
+          IK_PRINTF("PostCommand: keystroke queue is full\r\n");
+          return false;
+        }
+        break;
+
+      case IK_CMD_KEYBOARD_UNICODE: {
+        // UTF-16 code unit, character is typed on down
+        uint16_t const unit = (uint16_t)((command[1] << 8) | command[2]);
+        if (command[3] != IK_DOWN) {
+          break;
+        }
+
+        if (unit >= 0xd800 && unit <= 0xdbff) {
+          m_unicodeLead = unit;
+        } else if (unit >= 0xdc00 && unit <= 0xdfff) {
+          if (m_unicodeLead) {
+            PostUnicode(0x10000 + ((uint32_t)(m_unicodeLead - 0xd800) << 10) +
+                        (unit - 0xdc00));
+          }
+          m_unicodeLead = 0;
+        } else {
+          m_unicodeLead = 0;
+          return PostUnicode(unit);
+        }
+        break;
+      }
+
       default:
         break;
       }
@@ -608,16 +1471,15 @@ void Adafruit_IntelliKeys::PostDelay(uint8_t msec) {
   PostCommand(command);
 }
 
-void Adafruit_IntelliKeys::PostKey(int code, int direction, int delayAfter) {
-  //  track shift status and last code up for smart typing.
-
-  if (direction == IK_UP) {
-    if (code == UNIVERSAL_SHIFT || code == UNIVERSAL_RIGHT_SHIFT) {
-      m_bShifted = true;
-    } else {
-      m_lastCodeUp = code;
-      m_bShifted = false;
+void Adafruit_IntelliKeys::PostKey(int code, int direction, int delayAfter,
+                                   bool record) {
+  //  track shift status and typed keys for smart typing.
+  if (code == UNIVERSAL_SHIFT || code == UNIVERSAL_RIGHT_SHIFT) {
+    if (direction != IK_TOGGLE) {
+      m_bShifted = (direction == IK_DOWN);
     }
+  } else if (direction == IK_UP && record) {
+    RecordTyped(ik_universal_to_hid((uint8_t)code), m_bShifted);
   }
 
   uint8_t command[IK_REPORT_LEN];
@@ -629,6 +1491,254 @@ void Adafruit_IntelliKeys::PostKey(int code, int direction, int delayAfter) {
   PostCommand(command);
 }
 
+// Queue the key sequence typing code point, all or nothing so that a full
+// queue does not leave the host input method half way
+bool Adafruit_IntelliKeys::PostUnicode(uint32_t code_point) {
+  ik_key_event_t const *events;
+  uint8_t const count = m_unicode.getSequence(code_point, &events);
+  if (count == 0 || tu_fifo_remaining(&_key_ff) < count) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    PostKey(events[i].code, events[i].direction, 0, false);
+  }
+
+  // input method keys are not text, the character is of unknown class
+  RecordTyped(0, false);
+  return true;
+}
+
+// Queue a key press and release, optionally shifted
+void Adafruit_IntelliKeys::PostTap(uint8_t code, bool shift) {
+  if (shift) {
+    PostKey(UNIVERSAL_SHIFT, IK_DOWN);
+  }
+  PostKey(code, IK_DOWN);
+  PostKey(code, IK_UP);
+  if (shift) {
+    PostKey(UNIVERSAL_SHIFT, IK_UP);
+  }
+}
+
+// Queue a key press and release with the modifiers of its report
+bool Adafruit_IntelliKeys::PostChord(ik_report_keyboard_t const *key) {
+  uint8_t const code = ik_hid_to_universal(key->keycode);
+  if (code == 0 || tu_fifo_remaining(&_key_ff) < 2 + 2 * 8) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < 8; i++) {
+    if (key->modifier & (1u << i)) {
+      PostKey(ik_hid_to_universal(HID_KEY_CONTROL_LEFT + i), IK_DOWN);
+    }
+  }
+  PostKey(code, IK_DOWN);
+  PostKey(code, IK_UP);
+  for (uint8_t i = 8; i-- > 0;) {
+    if (key->modifier & (1u << i)) {
+      PostKey(ik_hid_to_universal(HID_KEY_CONTROL_LEFT + i), IK_UP);
+    }
+  }
+
+  return true;
+}
+
+// Type the rest of a predicted word and a space, all or nothing so that a full
+// queue does not leave half a word
+bool Adafruit_IntelliKeys::PostPrediction(uint8_t index) {
+  char const *completion = m_predict.getCompletion(index);
+  if (completion == NULL) {
+    return false;
+  }
+
+  // typing records keys, which changes the prediction
+  char text[IK_PREDICT_WORD_MAX + 1];
+  strncpy(text, completion, sizeof(text) - 1);
+  text[sizeof(text) - 1] = 0;
+
+  size_t const len = strlen(text);
+  if (tu_fifo_remaining(&_key_ff) < 2 * (len + 1)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    ik_report_keyboard_t kb;
+    if (IKMacro::asciiToKeyboard(text[i], &kb)) {
+      PostTap(ik_hid_to_universal(kb.keycode), kb.modifier != 0);
+    }
+  }
+  PostTap(UNIVERSAL_SPACE, false);
+
+  return true;
+}
+
+// Typed text is followed by smart typing and word prediction
+void Adafruit_IntelliKeys::RecordTyped(uint8_t keycode, bool shifted) {
+  m_smartTyping.record(keycode, shifted);
+  m_predict.record(keycode, shifted);
+}
+
+void Adafruit_IntelliKeys::ClearTyped(void) {
+  m_smartTyping.clear();
+  m_predict.clear();
+}
+
+void Adafruit_IntelliKeys::setSmartTyping(bool enable) {
+  IKSettings::GetSettings()->m_bSmartTyping = enable;
+  m_smartTyping.clear();
+
+  // not written here, this may run in the USB host path
+  m_settingsChangeTime = millis();
+  __sync_synchronize();
+  m_settingsChangeCount = m_settingsChangeCount + 1;
+}
+
+// Look up smart typing rules for a pressed key. If a rule matches, the key
+// and the keys added by the rule are typed through the keystroke queue and
+// true is returned. Otherwise the key is only recorded and output as usual.
+// While the queue is still typing, keys are typed through it as well so that
+// they are not output ahead of the queued ones.
+bool Adafruit_IntelliKeys::SmartTypeKey(ik_report_keyboard_t const *key) {
+  uint8_t const keycode = key->keycode;
+  if (keycode == 0 || keycode >= IK_NKRO_KEYCODE_COUNT) {
+    return false;
+  }
+
+  uint8_t const shift_mask =
+      KEYBOARD_MODIFIER_LEFTSHIFT | KEYBOARD_MODIFIER_RIGHTSHIFT;
+  uint8_t const modifier =
+      key->modifier | m_kbReport.modifier | m_modifiers.getHidModifier();
+  bool const shifted = (modifier & shift_mask) != 0;
+  bool const queued = !tu_fifo_empty(&_key_ff);
+
+  // shortcuts (ctrl, alt, gui) are not text
+  if (modifier & ~shift_mask) {
+    bool const posted = queued && PostChord(key);
+    RecordTyped(0, false);
+    return posted;
+  }
+
+  uint8_t action = 0;
+  if (IKSettings::GetSettings()->m_bSmartTyping) {
+    action = m_smartTyping.lookup(keycode, shifted);
+  }
+
+  // key down/up, shift down/up, backspace and space or retyped I
+  uint8_t const code = ik_hid_to_universal(keycode);
+  if ((action == 0 && !queued) || code == 0 ||
+      tu_fifo_remaining(&_key_ff) < 12) {
+    RecordTyped(keycode, shifted);
+    return false;
+  }
+
+  if (action & (IK_SMART_ERASE_SPACE | IK_SMART_CAPITALIZE_I)) {
+    PostTap(UNIVERSAL_BACKSPACE, false);
+  }
+  if (action & IK_SMART_CAPITALIZE_I) {
+    PostTap(ik_hid_to_universal(HID_KEY_I), true);
+  }
+  if (action & IK_SMART_ADD_SPACE) {
+    PostTap(UNIVERSAL_SPACE, false);
+  }
+  PostTap(code, shifted || (action & IK_SMART_CAPITALIZE));
+
+  return true;
+}
+
+// Put a universal code key down or up in the keyboard report, return false if
+// it is already in that state or not a key
+bool Adafruit_IntelliKeys::SetKeystrokeKey(uint8_t code, bool down) {
+  uint32_t const mask = 1ul << (code % 32);
+  bool const held = (m_keystrokeHeld[code / 32] & mask) != 0;
+
+  ik_report_t report;
+  report.type = IK_REPORT_TYPE_KEYBOARD;
+  if (down == held || !ik_universal_to_keyboard(code, &report.keyboard)) {
+    return false;
+  }
+
+  m_keystrokeHeld[code / 32] ^= mask;
+  UpdateKeyReport(&report, down);
+  return true;
+}
+
+// Play queued keystrokes, one event per gap. Next event is timed from when
+// the previous one was due so that pacing does not depend on how often we are
+// called, unless we are late by more than a gap.
+void Adafruit_IntelliKeys::ProcessKeystrokes(uint32_t now) {
+  if ((int32_t)(now - m_keystrokeNext) < 0) {
+    return;
+  }
+
+  uint8_t event[4];
+  if (!tu_fifo_read(&_key_ff, event)) {
+    if (m_keystrokeStart) {
+      m_typingTime += m_keystrokeNext - m_keystrokeStart;
+      m_keystrokeStart = 0;
+    }
+    return;
+  }
+
+  uint32_t base = now;
+  if (m_keystrokeStart == 0) {
+    m_keystrokeStart = now;
+  } else if (now - m_keystrokeNext < IK_KEYSTROKE_GAP) {
+    base = m_keystrokeNext;
+  }
+
+  uint8_t const code = event[0];
+  uint8_t const direction = event[1];
+  uint16_t const delay_after = (uint16_t)(event[2] | (event[3] << 8));
+
+  bool down = (direction == IK_DOWN);
+  if (direction == IK_TOGGLE) {
+    down = !(m_keystrokeHeld[code / 32] & (1ul << (code % 32)));
+  }
+
+  if (SetKeystrokeKey(code, down) && down) {
+    ik_report_keyboard_t kb;
+    ik_universal_to_keyboard(code, &kb);
+    if (kb.keycode) {
+      m_typedCount++;
+    }
+  }
+
+  m_keystrokeNext =
+      base + ((delay_after > IK_KEYSTROKE_GAP) ? delay_after : IK_KEYSTROKE_GAP);
+}
+
+// Output next macro key state once the previous one is taken by host
+void Adafruit_IntelliKeys::ProcessMacro(uint32_t now) {
+  if (!m_macro.isPlaying()) {
+    return;
+  }
+
+  // wait until previous state is copied into a report
+  if ((int32_t)(m_kbTakenSeq - m_macroSeq) < 0 &&
+      now - m_macroTime < IK_MACRO_TIMEOUT) {
+    return;
+  }
+
+  ik_report_t report;
+  report.type = IK_REPORT_TYPE_KEYBOARD;
+  bool down;
+  if (m_macro.next(&report.keyboard, &down)) {
+    UpdateKeyReport(&report, down);
+    PublishKeyboardReport();
+    m_macroSeq = m_kbSeq;
+    m_macroTime = now;
+  }
+}
+
+uint32_t Adafruit_IntelliKeys::getTypingRate(void) {
+  uint32_t time = m_typingTime;
+  if (m_keystrokeStart) {
+    time += millis() - m_keystrokeStart;
+  }
+  return time ? (uint32_t)((uint64_t)m_typedCount * 60000 / time) : 0;
+}
+
 void Adafruit_IntelliKeys::SetLEDs(void) {
   if (!IsSwitchedOn()) {
     return;
@@ -638,10 +1748,16 @@ void Adafruit_IntelliKeys::SetLEDs(void) {
     return;
   }
 
-  bool bShift = (m_modShift.GetState() != 0);
-  bool bControl = (m_modControl.GetState() != 0);
-  bool bAlt = (m_modAlt.GetState() != 0);
-  bool bCommand = (m_modCommand.GetState() != 0);
+  //  LEDs are used as scan indicator
+  if (m_scanLed) {
+    return;
+  }
+
+  uint8_t const latched = m_modifiers.getHidModifier();
+  bool bShift = (latched & KEYBOARD_MODIFIER_LEFTSHIFT) != 0;
+  bool bControl = (latched & KEYBOARD_MODIFIER_LEFTCTRL) != 0;
+  bool bAlt = (latched & KEYBOARD_MODIFIER_LEFTALT) != 0;
+  bool bCommand = (latched & KEYBOARD_MODIFIER_LEFTGUI) != 0;
   bool bNumLock = IsNumLockOn();
   bool bMouse = IsMouseDown();
   bool bCapsLock = IsCapsLockOn();
@@ -751,44 +1867,273 @@ void Adafruit_IntelliKeys::OnToggle(int newValue) {
 }
 
 void Adafruit_IntelliKeys::OnSwitch(int nswitch, int state) {
+  if (nswitch < 1 || nswitch > IK_NUM_SWITCHES ||
+      m_switches[nswitch - 1] == state) {
+    return;
+  }
+
+  if (state) {
+    ScheduleCorrect(IK_CORRECT_INTERVAL_HELD);
+  }
   m_switches[nswitch - 1] = state;
+
+  // switch feeds the same key pipeline as membrane, unless it drives scanning
+  if (IsScanSwitch(nswitch)) {
+    if (state) {
+      OnScanSwitch(nswitch);
+    }
+  } else if (state) {
+    KeyDown(IK_SWITCH_KEY_ID(nswitch - 1));
+  } else {
+    KeyUp(IK_SWITCH_KEY_ID(nswitch - 1));
+  }
+
+  InterpretSwitch(nswitch - 1, state);
 }
 
-void Adafruit_IntelliKeys::OnSensorChange(int sensor, int value) {
-  uint32_t now = millis();
+void Adafruit_IntelliKeys::setSwitchOverlay(uint8_t index,
+                                            ik_switch_overlay_t const *overlay) {
+  if (index >= MAX_SWITCH_OVERLAYS) {
+    return;
+  }
 
-  //  save the current sensor value
-  m_sensors[sensor] = value;
+  // key mapping belongs to Periodic(), publish the request there
+  m_switchOverlaySeq = m_switchOverlaySeq + 1;
+  __sync_synchronize();
+  m_switchOverlayRequest.overlays[index] = *overlay;
+  __sync_synchronize();
+  m_switchOverlaySeq = m_switchOverlaySeq + 1;
+}
+
+void Adafruit_IntelliKeys::selectSwitchOverlay(uint8_t index) {
+  if (index >= MAX_SWITCH_OVERLAYS) {
+    return;
+  }
+
+  m_switchOverlaySeq = m_switchOverlaySeq + 1;
+  __sync_synchronize();
+  m_switchOverlayRequest.select = index;
+  __sync_synchronize();
+  m_switchOverlaySeq = m_switchOverlaySeq + 1;
+}
+
+void Adafruit_IntelliKeys::ApplySwitchOverlays(void) {
+  uint32_t seq = m_switchOverlaySeq;
+  if (seq == m_switchOverlayApplied) {
+    return;
+  }
+
+  uint8_t select;
+  do {
+    seq = m_switchOverlaySeq;
+    __sync_synchronize();
+    memcpy(m_switchOverlays, m_switchOverlayRequest.overlays,
+           sizeof(m_switchOverlays));
+    select = m_switchOverlayRequest.select;
+    __sync_synchronize();
+  } while ((seq & 1) || seq != m_switchOverlaySeq);
+
+  m_switchOverlayApplied = seq;
+  m_switchOverlay = select;
+  RebuildHIDReport();
+}
+
+// Touch mode changes how membrane cells press keys, key state belongs to
+// Periodic()
+void Adafruit_IntelliKeys::ApplyTouchMode(void) {
+  bool const enabled = m_touchModeRequest;
+  if (enabled == m_touchMode) {
+    return;
+  }
+
+  m_touchMode = enabled;
+  RebuildHIDReport();
+}
+
+// Standard overlay is refilled in place, only this core resolves key ids
+void Adafruit_IntelliKeys::ApplyMouseAccessTrackpad(void) {
+  bool const enable = m_mouseAccessTrackpad;
+  if (enable == m_mouseAccessTrackpadApplied) {
+    return;
+  }
+
+  m_mouseAccessTrackpadApplied = enable;
+  IKOverlay::setStdMouseAccessTrackpad(enable);
+  RebuildHIDReport();
+}
+
+//--------------------------------------------------------------------+
+// Scanning
+//--------------------------------------------------------------------+
+
+void Adafruit_IntelliKeys::setScanSwitch(uint8_t select_switch,
+                                         uint8_t step_switch) {
+  if (select_switch > IK_NUM_SWITCHES || step_switch > IK_NUM_SWITCHES) {
+    return;
+  }
+
+  // usually called from the other core, scan state and HID report belong to
+  // Periodic(): publish the request there
+  m_scanRequest = (uint16_t)(select_switch | (step_switch << 8));
+  __sync_synchronize();
+  m_scanRequestCount++;
+}
+
+void Adafruit_IntelliKeys::ApplyScanSwitch(void) {
+  uint8_t const count = m_scanRequestCount;
+  if (count == m_scanAppliedCount) {
+    return;
+  }
+  __sync_synchronize();
+  uint16_t const request = m_scanRequest;
+  m_scanAppliedCount = count;
+
+  uint8_t const select_switch = (uint8_t)(request & 0xff);
+  uint8_t const step_switch = (uint8_t)(request >> 8);
+
+  m_scanSwitch = select_switch;
+  m_scanStepSwitch = select_switch ? step_switch : 0;
+  m_scan.setAutoStep(m_scanStepSwitch == 0);
+  m_scan.stop();
+  UpdateScanIndicator(false);
+
+  // switches taken by (or given back from) scanning
+  RebuildHIDReport();
+}
+
+bool Adafruit_IntelliKeys::IsScanSwitch(int nswitch) {
+  return m_scanSwitch &&
+         (nswitch == m_scanSwitch || nswitch == m_scanStepSwitch);
+}
+
+void Adafruit_IntelliKeys::OnScanSwitch(int nswitch) {
+  uint32_t const now = millis();
+  uint32_t const now_us = micros();
+
+  if (nswitch == m_scanStepSwitch) {
+    if (m_scan.step(now, now_us)) {
+      UpdateScanIndicator(true);
+    }
+    return;
+  }
+
+  uint8_t const key_id = m_scan.select(now, now_us);
+  if (key_id) {
+    OnScanSelect(key_id);
+  }
+  UpdateScanIndicator(false);
+}
+
+// Selected key is tapped for IK_SCAN_PRESS_TIME. It bypasses the input filter
+// since the switch press is already a deliberate selection.
+void Adafruit_IntelliKeys::OnScanSelect(uint8_t key_id) {
+  ik_report_t const *report = GetKeyReport(key_id);
+  if (report == NULL) {
+    return;
+  }
+
+  if (m_scanKey) {
+    m_timer.cancel(IK_TIMER_SCAN_RELEASE);
+    OutputKeyUp(m_scanKey);
+  }
+
+  IK_PRINTF("scan select key %u\r\n", key_id);
+  InterpretReport(report);
+  OutputKeyDown(key_id);
+
+  m_scanKey = key_id;
+  m_timer.start(IK_TIMER_SCAN_RELEASE, millis() + IK_SCAN_PRESS_TIME);
+}
+
+// Scan rows follow the current overlay
+void Adafruit_IntelliKeys::UpdateScan(void) {
+  m_scan.build(GetCurrentOverlay());
+  UpdateScanIndicator(false);
+}
 
-  //  what's the new overlay value
-  int v[IK_NUM_SENSORS];
+// One of the 9 LEDs shows highlighted row or key position, modifier lights
+// (SetLEDs) are paused while scanning
+void Adafruit_IntelliKeys::UpdateScanIndicator(bool sound) {
+  uint8_t led = 0;
+  if (m_scan.getState() != IK_SCAN_IDLE) {
+    led = (uint8_t)(m_scan.getPosition() % 9 + 1);
+  }
 
-  for (int i = 0; i < IK_NUM_SENSORS; i++) {
-    v[i] = 0;
-    int midway;
-    if (m_bEepromValid) {
-      midway = (50 * m_eepromData.sensorBlack[i] +
-                50 * m_eepromData.sensorWhite[i]) /
-               100;
+  if (led != m_scanLed) {
+    if (m_scanLed == 0) {
+      for (uint8_t i = 1; i <= 9; i++) {
+        PostSetLED(i, false);
+      }
     } else {
-      midway = 150;
+      PostSetLED(m_scanLed, false);
     }
 
-    if (m_sensors[i] > midway) {
-      v[i] = 1;
+    m_scanLed = led;
+    if (led) {
+      PostSetLED(led, true);
+    } else {
+      SetLEDs(); // scanning stopped, modifier lights are back
     }
   }
 
-  int newVal = 0;
-  for (int i = 0; i < IK_NUM_SENSORS; i++) {
-    newVal += v[i] * (1 << i);
+  if (sound && led) {
+    KeySoundVol(IK_SCAN_TONE_TIME);
+  }
+
+  if (_scan_cb) {
+    _scan_cb(m_scan.getState(), m_scan.getRow(), m_scan.getKey());
   }
+}
+
+static inline uint8_t median3(uint8_t a, uint8_t b, uint8_t c) {
+  if (a > b) {
+    uint8_t const t = a;
+    a = b;
+    b = t;
+  }
+  // a <= b
+  return (c <= a) ? a : ((c >= b) ? b : c);
+}
+
+// Drop sensor chatter: median of last 3 readings, forwarded only if it moves
+// enough from last forwarded value. Return true if value should be processed.
+bool Adafruit_IntelliKeys::FilterSensor(uint8_t sensor, uint8_t value,
+                                        int *filtered) {
+  if (sensor >= IK_NUM_SENSORS) {
+    return false;
+  }
+
+  uint8_t *history = m_sensorHistory[sensor];
+  history[0] = history[1];
+  history[1] = history[2];
+  history[2] = value;
+
+  // first reading is forwarded as is so that recognition starts right away
+  if (m_sensorReadings[sensor] == 0) {
+    history[0] = history[1] = value;
+    m_sensorReadings[sensor] = 1;
+    *filtered = value;
+    return true;
+  }
+
+  int const median = median3(history[0], history[1], history[2]);
+  if (abs(median - m_sensors[sensor]) < IK_SENSOR_DEADBAND) {
+    return false;
+  }
+
+  *filtered = median;
+  return true;
+}
 
-  //  if the value changed, record what and when
-  if (newVal != m_lastOverlay) {
-    m_lastOverlay = newVal;
-    m_lastOverlayTime = now;
+void Adafruit_IntelliKeys::OnSensorChange(int sensor, int value) {
+  if (sensor < 0 || sensor >= IK_NUM_SENSORS) {
+    return;
   }
+
+  //  save the current sensor value
+  m_sensors[sensor] = value;
+
+  m_recognizer.update(sensor, value, millis());
 }
 
 void Adafruit_IntelliKeys::ProcessInput(uint8_t const *data, uint8_t len) {
@@ -807,25 +2152,26 @@ void Adafruit_IntelliKeys::ProcessInput(uint8_t const *data, uint8_t len) {
   switch (event_id) {
   case IK_EVENT_MEMBRANE_PRESS:
     OnMembranePress(data[1], data[2]);
-    InterpretRaw();
     PostReportDataToControlPanel();
     break;
 
   case IK_EVENT_MEMBRANE_RELEASE:
     OnMembraneRelease(data[1], data[2]);
-    InterpretRaw();
     PostReportDataToControlPanel();
     break;
 
   case IK_EVENT_SWITCH:
     OnSwitch(data[1], data[2]);
-    InterpretRaw();
     PostReportDataToControlPanel();
     break;
 
-  case IK_EVENT_SENSOR_CHANGE:
-    OnSensorChange(data[1], data[2]);
+  case IK_EVENT_SENSOR_CHANGE: {
+    int value;
+    if (FilterSensor(data[1], data[2], &value)) {
+      OnSensorChange(data[1], value);
+    }
     break;
+  }
 
   case IK_EVENT_VERSION:
     // JR - June 2012 - set the firmware version
@@ -843,13 +2189,11 @@ void Adafruit_IntelliKeys::ProcessInput(uint8_t const *data, uint8_t len) {
 
   case IK_EVENT_CORRECT_MEMBRANE:
     OnCorrectMembrane(data[1], data[2]);
-    InterpretRaw();
     PostReportDataToControlPanel();
     break;
 
   case IK_EVENT_CORRECT_SWITCH:
     OnCorrectSwitch(data[1]);
-    InterpretRaw();
     PostReportDataToControlPanel();
     break;
 
@@ -882,10 +2226,16 @@ void Adafruit_IntelliKeys::ProcessInput(uint8_t const *data, uint8_t len) {
 
 void Adafruit_IntelliKeys::PostLiftAllModifiers() {
   // run IK_CMD_LIFTALLMODIFIERS right here instead of using PostCommand
-  m_modShift.SetState(kModifierStateOff);
-  m_modAlt.SetState(kModifierStateOff);
-  m_modControl.SetState(kModifierStateOff);
-  m_modCommand.SetState(kModifierStateOff);
+  m_modifiers.update(IK_MOD_KEYBOARD_MASK, IK_MOD_EVENT_CLEAR,
+                     kSettingsShiftLatching, millis());
+
+  uint8_t const modifier_codes[] = {
+      UNIVERSAL_SHIFT, UNIVERSAL_RIGHT_SHIFT, UNIVERSAL_CONTROL,
+      UNIVERSAL_RIGHT_CONTROL, UNIVERSAL_ALT, UNIVERSAL_ALTGR,
+      UNIVERSAL_COMMAND};
+  for (uint8_t i = 0; i < TU_ARRAY_SIZE(modifier_codes); i++) {
+    SetKeystrokeKey(modifier_codes[i], false);
+  }
 }
 
 void Adafruit_IntelliKeys::PostCPRefresh() {
@@ -901,10 +2251,12 @@ void Adafruit_IntelliKeys::ResetKeyboard(void) {
 
 void Adafruit_IntelliKeys::ResetMouse(void) {
   //  reset mouse
-  m_mouseDown.SetState(kModifierStateOff);
+  m_modifiers.update(1u << IK_MOD_MOUSE_DOWN, IK_MOD_EVENT_CLEAR,
+                     kSettingsShiftLatching, millis());
 }
 
 void Adafruit_IntelliKeys::OnStdOverlayChange() {
+  ClearTyped();
   ResetKeyboard();
   ResetMouse();
   PostLiftAllModifiers();
@@ -1025,12 +2377,18 @@ void Adafruit_IntelliKeys::SettleOverlay() {
   uint32_t now = millis();
 
   //  settle overlay
-  if (m_lastOverlay != m_currentOverlay && now > m_lastOverlayTime + 1000) {
-    m_currentOverlay = m_lastOverlay;
-    IK_PRINTF("Settled on overlay %d\n", m_currentOverlay);
+  int overlay;
+  if (m_recognizer.settle(now, &overlay) && overlay != m_currentOverlay) {
+    m_currentOverlay = overlay;
+    IK_PRINTF("Settled on overlay %d in %lu ms (%u flaps)\n", m_currentOverlay,
+              m_recognizer.getLastSettleTime(), m_recognizer.getFlapCount());
 
     SetLevel(1);
 
+    // key mapping changed
+    RebuildHIDReport();
+    UpdateScan();
+
     OnStdOverlayChange();
   }
 }
@@ -1057,32 +2415,90 @@ void Adafruit_IntelliKeys::KeySoundVol(int msLength, int vol) {
   PostCommand(report);
 }
 
+#define EEPROM_ALL_MASK ((1ull << sizeof(eeprom_t)) - 1)
+#define EEPROM_SN_MASK ((1ull << IK_EEPROM_SN_SIZE) - 1)
+
+// Keep up to IK_EEPROM_WINDOW byte requests in flight, re-request timed out
+// ones with exponential backoff. Only in-flight requests are checked so it is
+// cheap to call every Periodic().
+void Adafruit_IntelliKeys::FetchEEProm(uint32_t now) {
+  //  timed out requests can be sent again
+  uint64_t inflight = m_eepromInflight;
+  while (inflight) {
+    uint8_t const i = (uint8_t)__builtin_ctzll(inflight);
+    inflight &= inflight - 1;
+
+    uint32_t const timeout = IK_EEPROM_TIMEOUT << m_eepromRetry[i];
+    if (now - m_eepromRequestTime[i] >= timeout) {
+      m_eepromInflight &= ~(1ull << i);
+      if (m_eepromRetry[i] < IK_EEPROM_RETRY_MAX) {
+        m_eepromRetry[i]++;
+      }
+    }
+  }
+
+  //  fill the window with missing bytes
+  uint64_t missing = EEPROM_ALL_MASK & ~(m_eepromDataValid | m_eepromInflight);
+  uint8_t count = (uint8_t)__builtin_popcountll(m_eepromInflight);
+
+  while (missing && count < IK_EEPROM_WINDOW) {
+    uint8_t const i = (uint8_t)__builtin_ctzll(missing);
+    missing &= missing - 1;
+
+    uint8_t report[8] = {
+        IK_CMD_EEPROM_READBYTE, (uint8_t)(0x80 + i), 0x1F, 0, 0, 0, 0, 0};
+    if (!PostCommand(report)) {
+      break; // command queue is full, missing bytes are requested next time
+    }
+
+    m_eepromRequestTime[i] = now;
+    m_eepromInflight |= (1ull << i);
+    count++;
+  }
+}
+
 void Adafruit_IntelliKeys::StoreEEProm(uint8_t data, uint8_t add_lsb,
                                        uint8_t add_msb) {
   //  store the uint8_t received;
   int ndx = add_lsb - 0x80;
+  if (ndx < 0 || ndx >= (int)sizeof(eeprom_t)) {
+    return;
+  }
 
   uint8_t *e = (uint8_t *)&m_eepromData;
   e[ndx] = data;
 
   //  mark the uint8_t valid;
-  m_eepromDataValid[ndx] = true;
+  m_eepromDataValid |= (1ull << ndx);
+  m_eepromInflight &= ~(1ull << ndx);
+
+  //  once serial number is read, use cached calibration of this board or
+  //  drop the guess if it is not known
+  if (!m_bSerialChecked &&
+      (m_eepromDataValid & EEPROM_SN_MASK) == EEPROM_SN_MASK) {
+    m_bSerialChecked = true;
+
+    eeprom_t cached;
+    if (m_cache.find(m_eepromData.serialnumber, &cached)) {
+      m_recognizer.setCalibration(&cached);
+    } else {
+      m_recognizer.clearCalibration();
+    }
+  }
 
   //  check to see if all the uint8_ts are valid.
   //  if so, say we're valid and refresh the
   //  control panel.
-  int nInvalid = 0;
-  for (unsigned int i = 0; i < sizeof(eeprom_t); i++) {
-    if (!m_eepromDataValid[i]) {
-      nInvalid++;
-    }
-  }
-
-  if (nInvalid == 0 && !m_bEepromValid) {
+  if (m_eepromDataValid == EEPROM_ALL_MASK && !m_bEepromValid) {
     if (m_eepromData.serialnumber[0] == 'C' &&
         m_eepromData.serialnumber[1] == '-') {
       m_bEepromValid = true;
       IK_PRINTF("EEPROM data valid\n");
+
+      // verify cache: update it if calibration is changed or board is new
+      m_recognizer.setCalibration(&m_eepromData);
+      m_cache.save(&m_eepromData);
+
       PostCPRefresh();
     }
   }
@@ -1102,6 +2518,7 @@ void Adafruit_IntelliKeys::hid_reprot_received_cb(uint8_t daddr, uint8_t idx,
   }
 
   ProcessInput(report, len);
+  PublishKeyboardReport();
 
   if (!tuh_hid_receive_report(daddr, idx)) {
     IK_PRINTF("Failed to receive report\n");
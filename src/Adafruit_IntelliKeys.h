@@ -28,8 +28,20 @@
 #include "Adafruit_TinyUSB.h"
 #include "intellikeysdefs.h"
 
+#include "IKCache.h"
+#include "IKFilter.h"
+#include "IKKeycode.h"
+#include "IKMacro.h"
 #include "IKModifier.h"
+#include "IKMouse.h"
 #include "IKOverlay.h"
+#include "IKPredict.h"
+#include "IKRecognizer.h"
+#include "IKScan.h"
+#include "IKSmartTyping.h"
+#include "IKTimer.h"
+#include "IKTouch.h"
+#include "IKUnicode.h"
 #include "IKUniversal.h"
 
 //  maximum numbers
@@ -39,11 +51,157 @@
 
 #define IK_CMD_FIFO_SIZE 128
 
+// Keystroke queue (IK_CMD_KEYBOARD) size in events, and minimum time (ms)
+// between 2 events so that each key state makes it into a keyboard report
+#define IK_KEYSTROKE_FIFO_SIZE 64
+#define IK_KEYSTROKE_GAP 10
+
+// Macro playback outputs the next key state as soon as the keyboard report
+// with the previous one is polled (i.e the endpoint is ready again), or after
+// IK_MACRO_TIMEOUT ms if the report is not polled
+#define IK_MACRO_TIMEOUT 20
+
+// Settings changed from an overlay (e.g smart typing key) are stored once they
+// are unchanged for IK_SETTINGS_SAVE_DELAY ms, see saveChangedSettings()
+#define IK_SETTINGS_SAVE_DELAY 3000
+
+// Minimum interval (ms) between flash writes of saveChangedSettings(), changes
+// made meanwhile are written together
+#define IK_FLASH_WRITE_INTERVAL 30000
+
+// Number of keycodes covered by the NKRO keyboard bitmap: usage 0x00 - 0xDF.
+// Modifiers (usage 0xE0 - 0xE7) are reported in the modifier byte.
+#define IK_NKRO_KEYCODE_COUNT 224
+
+// N-Key Rollover keyboard report: 1 bit per keycode instead of 6 keycode slots
+// of the boot protocol, use with TUD_HID_REPORT_DESC_IK_NKRO_KEYBOARD()
+typedef struct __attribute__((packed)) {
+  uint8_t modifier;
+  uint8_t reserved;
+  uint8_t keybitmap[IK_NKRO_KEYCODE_COUNT / 8];
+} ik_nkro_keyboard_report_t;
+
+// HID Report Descriptor for ik_nkro_keyboard_report_t
+#define TUD_HID_REPORT_DESC_IK_NKRO_KEYBOARD(...)                              \
+  HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),                                      \
+      HID_USAGE(HID_USAGE_DESKTOP_KEYBOARD),                                   \
+      HID_COLLECTION(HID_COLLECTION_APPLICATION), /* Report ID if any */       \
+      __VA_ARGS__ /* 8 bits Modifier Keys (Shift, Control, Alt) */            \
+      HID_USAGE_PAGE(HID_USAGE_PAGE_KEYBOARD),                                 \
+      HID_USAGE_MIN(224), HID_USAGE_MAX(231), HID_LOGICAL_MIN(0),              \
+      HID_LOGICAL_MAX(1), HID_REPORT_COUNT(8), HID_REPORT_SIZE(1),             \
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),                       \
+      /* 8 bit reserved */                                                     \
+      HID_REPORT_COUNT(1), HID_REPORT_SIZE(8), HID_INPUT(HID_CONSTANT),        \
+      /* Output 5-bit LED Indicator Kana | Compose | ScrollLock | CapsLock |   \
+         NumLock */                                                            \
+      HID_USAGE_PAGE(HID_USAGE_PAGE_LED), HID_USAGE_MIN(1), HID_USAGE_MAX(5),  \
+      HID_REPORT_COUNT(5), HID_REPORT_SIZE(1),                                 \
+      HID_OUTPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),                      \
+      /* led padding */                                                        \
+      HID_REPORT_COUNT(1), HID_REPORT_SIZE(3), HID_OUTPUT(HID_CONSTANT),       \
+      /* 1 bit per keycode */                                                  \
+      HID_USAGE_PAGE(HID_USAGE_PAGE_KEYBOARD), HID_USAGE_MIN(0),               \
+      HID_USAGE_MAX(IK_NKRO_KEYCODE_COUNT - 1), HID_LOGICAL_MIN(0),            \
+      HID_LOGICAL_MAX(1), HID_REPORT_COUNT(IK_NKRO_KEYCODE_COUNT),             \
+      HID_REPORT_SIZE(1), HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),   \
+      HID_COLLECTION_END
+
+// Key repeat when IKSettings m_bUseSystemRepeatSettings is off: first repeat
+// after IK_REPEAT_DELAY (or repeat interval if longer), then at an interval
+// from IK_REPEAT_INTERVAL_SLOW (lowest rate) to IK_REPEAT_INTERVAL_FAST
+// (highest rate). Each repeat releases the keycode for IK_REPEAT_BREAK_TIME
+// which must be longer than keyboard endpoint interval.
+#define IK_REPEAT_DELAY 500
+#define IK_REPEAT_INTERVAL_SLOW 1000
+#define IK_REPEAT_INTERVAL_FAST 33
+#define IK_REPEAT_BREAK_TIME 16
+
+// Membrane correction (re-read of all pressed cells) interval in ms:
+// - IK_CORRECT_INTERVAL_MIN after suspected event loss until consistent
+// - IK_CORRECT_INTERVAL_HELD while something is pressed, to catch missed
+//   releases (stuck keys)
+// - doubled after each consistent correction while idle, up to
+//   IK_CORRECT_INTERVAL_MAX
+// IK_CORRECT_TIMEOUT is the time to wait for CORRECT_DONE before retrying.
+#define IK_CORRECT_INTERVAL_MIN 125
+#define IK_CORRECT_INTERVAL_HELD 500
+#define IK_CORRECT_INTERVAL_MAX 8000
+#define IK_CORRECT_TIMEOUT 1000
+
+// EEPROM is read byte by byte with at most IK_EEPROM_WINDOW requests in
+// flight. A request not answered within IK_EEPROM_TIMEOUT is sent again with
+// its timeout doubled, up to IK_EEPROM_RETRY_MAX times.
+#define IK_EEPROM_WINDOW 4
+#define IK_EEPROM_TIMEOUT 100
+#define IK_EEPROM_RETRY_MAX 5
+
+// Sensor events are median-of-3 filtered per sensor and only forwarded to
+// overlay recognition when the result moves at least IK_SENSOR_DEADBAND from
+// the last forwarded value
+#define IK_SENSOR_DEADBAND 4
+
+// Key selected by scanning is pressed for IK_SCAN_PRESS_TIME (ms), each
+// highlight step clicks for IK_SCAN_TONE_TIME (ms)
+#define IK_SCAN_PRESS_TIME 50
+#define IK_SCAN_TONE_TIME 10
+
+// IKTimer ids
+enum {
+  IK_TIMER_REPEAT = 0,                                 // + key id
+  IK_TIMER_FILTER = IK_TIMER_REPEAT + IK_KEY_ID_COUNT, // + key id
+  IK_TIMER_SCAN = IK_TIMER_FILTER + IK_KEY_ID_COUNT,
+  IK_TIMER_SCAN_RELEASE,
+  IK_TIMER_COUNT
+};
+
+// Trackpad mode, see IKOverlay::setMembraneTrackpad()
+enum { IK_TRACKPAD_RELATIVE = 0, IK_TRACKPAD_ABSOLUTE };
+
+// Trackpad relative mode: pointer pixels per membrane cell of touch motion
+#define IK_TRACKPAD_GAIN 24
+
+// Trackpad relative mode: gain increment (in 1/256) per 1/256 cell of motion
+// between 2 touch updates i.e 256 doubles the gain at 1 cell per update
+#define IK_TRACKPAD_ACCEL 256
+
+// Absolute pointer logical maximum
+#define IK_ABS_MOUSE_MAX 0x7fff
+
+// Absolute pointer report for trackpad absolute mode, use with
+// TUD_HID_REPORT_DESC_IK_ABSMOUSE()
+typedef struct __attribute__((packed)) {
+  uint8_t buttons;
+  uint16_t x;
+  uint16_t y;
+} ik_abs_mouse_report_t;
+
+// HID Report Descriptor for ik_abs_mouse_report_t
+#define TUD_HID_REPORT_DESC_IK_ABSMOUSE(...)                                   \
+  HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP), HID_USAGE(HID_USAGE_DESKTOP_MOUSE),  \
+      HID_COLLECTION(HID_COLLECTION_APPLICATION), /* Report ID if any */       \
+      __VA_ARGS__ HID_USAGE(HID_USAGE_DESKTOP_POINTER),                        \
+      HID_COLLECTION(HID_COLLECTION_PHYSICAL),                                 \
+      HID_USAGE_PAGE(HID_USAGE_PAGE_BUTTON), HID_USAGE_MIN(1),                 \
+      HID_USAGE_MAX(5), HID_LOGICAL_MIN(0), HID_LOGICAL_MAX(1),                \
+      /* Left, Right, Middle, Backward, Forward buttons */                     \
+      HID_REPORT_COUNT(5), HID_REPORT_SIZE(1),                                 \
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),                       \
+      /* 3 bit padding */                                                      \
+      HID_REPORT_COUNT(1), HID_REPORT_SIZE(3), HID_INPUT(HID_CONSTANT),        \
+      HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP), /* X, Y absolute position */     \
+      HID_USAGE(HID_USAGE_DESKTOP_X), HID_USAGE(HID_USAGE_DESKTOP_Y),          \
+      HID_LOGICAL_MIN(0), HID_LOGICAL_MAX_N(IK_ABS_MOUSE_MAX, 2),              \
+      HID_REPORT_COUNT(2), HID_REPORT_SIZE(16),                                \
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE), HID_COLLECTION_END,   \
+      HID_COLLECTION_END
+
 class Adafruit_IntelliKeys {
 public:
   typedef void (*membrane_callback_t)(uint8_t row, uint8_t col, uint8_t state);
   typedef void (*switch_callback_t)(uint8_t sw, uint8_t state);
   typedef void (*toggle_callback_t)(uint8_t state);
+  typedef void (*scan_callback_t)(uint8_t state, uint8_t row, uint8_t key_id);
 
   Adafruit_IntelliKeys(void);
 
@@ -55,21 +213,130 @@ public:
   bool mount(uint8_t daddr);
   void umount(uint8_t daddr);
 
-  void setCustomOverlay(IKOverlay *overlay, uint32_t count) {
-    _custom_overlay = overlay;
-    _custom_overlay_count = count;
-  }
+  // Overlays used for overlay number 8 and up, applied by the next
+  // Periodic(). They are read from there on, don't modify them afterwards.
+  void setCustomOverlay(IKOverlay *overlay, uint32_t count);
 
   void getHIDReport(hid_keyboard_report_t *kb_report,
                     hid_mouse_report_t *mouse_report);
+  void getHIDReport(ik_nkro_keyboard_report_t *kb_report,
+                    hid_mouse_report_t *mouse_report);
+
+  // Keyboard and mouse pipelines can also be polled separately, each at its
+  // own endpoint rate. Return true only if the report should be sent:
+  // keyboard when it differs from the last one returned, mouse when there is
+  // motion or buttons are changed. Call only when the endpoint is ready since
+  // returned change is consumed.
+  bool getKeyboardReport(hid_keyboard_report_t *report);
+  bool getKeyboardReport(ik_nkro_keyboard_report_t *report);
+  bool getMouseReport(hid_mouse_report_t *report);
   void Periodic(void);
 
   void onMemBraneChanged(membrane_callback_t func) { _membrane_cb = func; }
   void onSwitchChanged(switch_callback_t func) { _switch_cb = func; }
   void onToggleChanged(toggle_callback_t func) { _toggle_cb = func; }
+  void onScanChanged(scan_callback_t func) { _scan_cb = func; }
 
   uint8_t const (*getMembrane(void))[IK_RESOLUTION_Y] { return m_membrane; }
 
+  // Touch mode: each blob of touched cells presses only the single key
+  // nearest to its centroid, instead of every key under the touched cells.
+  // Applied by the next Periodic().
+  void setTouchMode(bool enabled) { m_touchModeRequest = enabled; }
+  bool getTouchMode(void) { return m_touchModeRequest; }
+  IKTouch *getTouch(void) { return &m_touch; }
+
+  // Overlay recognition statistics (flaps, settle count and time)
+  IKRecognizer *getRecognizer(void) { return &m_recognizer; }
+
+  // Overlay with trackpad region moves pointer with touch motion: relative
+  // motion is merged into mouse report of getHIDReport(), absolute position
+  // is reported by getTrackpadAbsReport() which return false if not touched.
+  void setTrackpadMode(uint8_t mode) { m_trackpadMode = mode; }
+
+  // Standard Mouse Access overlay has no free region, with this its direction
+  // keys area (including the click key in the middle) becomes the trackpad.
+  // Click keys on both sides still click. Applied by the next Periodic().
+  void setMouseAccessTrackpad(bool enable) { m_mouseAccessTrackpad = enable; }
+  bool getTrackpadAbsReport(ik_abs_mouse_report_t *report);
+
+  // Switch overlays map the switch inputs to keyboard/mouse actions, one of
+  // them is selected at a time. Index 0 has a default mapping. Switch actions
+  // defined by the current membrane overlay take precedence. Changes are
+  // applied by the next Periodic(), call these from one core only.
+  void setSwitchOverlay(uint8_t index, ik_switch_overlay_t const *overlay);
+  void selectSwitchOverlay(uint8_t index);
+  uint8_t getSwitchOverlay(void) { return m_switchOverlayRequest.select; }
+
+  // Flash filesystem used to cache EEPROM calibration (keyed by serial number)
+  // so that a reattached board recognizes overlays without waiting for the
+  // EEPROM to be read, and to store IKSettings. Both are loaded here. Optional,
+  // must be mounted before a board is attached. The volume is only accessed
+  // from the core calling this, saveSettings() and saveChangedSettings().
+  void setFlashVolume(FatVolume *vol);
+
+  // Store IKSettings changed by the sketch, unchanged settings are not written
+  void saveSettings(void) { IKSettings::GetSettings()->Write(); }
+
+  // Store IKSettings changed from an overlay after IK_SETTINGS_SAVE_DELAY and
+  // calibration of a newly verified board. Call it from the loop that does not
+  // run the USB host. Writing flash still stalls the other core: on RP2040
+  // both cores are paused while a sector is erased and programmed, so USB host
+  // (PIO-USB) misses frames for that time. To keep this rare and harmless,
+  // writes wait until no key is down and are batched at most once per
+  // IK_FLASH_WRITE_INTERVAL.
+  void saveChangedSettings(void);
+
+  // Scanning access for switch users: rows of the current overlay then keys
+  // of the selected row are highlighted in turn (LEDs, click sound and
+  // onScanChanged callback), pressing the select switch picks the highlighted
+  // one. With a step switch, highlight moves only when it is pressed instead
+  // of every interval. Scan switches do not do their switch overlay action.
+  // Switch number is 1-based, 0 for none (select switch 0 disables scanning).
+  // Safe to call from either core, it is applied by the next Periodic().
+  void setScanSwitch(uint8_t select_switch, uint8_t step_switch = 0);
+  void setScanInterval(uint16_t ms) { m_scan.setInterval(ms); }
+  IKScan *getScan(void) { return &m_scan; } // state and timing statistics
+
+  // Minimum interval (ms) between pointer motion reports, pointer speed is
+  // time based and follows IKSettings m_iMouseSpeed regardless of interval
+  void setMouseInterval(uint8_t ms) { m_mouse.setInterval(ms); }
+
+  // Keystrokes posted by PostKey() (universal codes) are played into the
+  // keyboard report one event at a time, IK_KEYSTROKE_GAP ms apart or the
+  // event delayAfter if longer. Statistics: characters typed, time (ms) the
+  // queue was busy and typing rate in characters per minute.
+  uint32_t getTypedCount(void) { return m_typedCount; }
+  uint32_t getTypingTime(void) { return m_typingTime; }
+  uint32_t getTypingRate(void);
+
+  // Custom macros (strings or key sequences) typed by IK_REPORT_TYPE_MACRO
+  // keys with index IK_MACRO_CUSTOM_BASE + n, pool must stay valid
+  void setMacroPool(ik_macro_t const *pool, uint8_t count) {
+    m_macro.setCustomPool(pool, count);
+  }
+
+  // Unicode characters (IK_REPORT_TYPE_UNICODE keys, IK_CMD_KEYBOARD_UNICODE
+  // and PostUnicode()) are typed through the keystroke queue with the input
+  // method of the host, mode is IK_UNICODE_LINUX/WINDOWS/MACOS
+  void setUnicodeMode(uint8_t mode) { m_unicode.setMode(mode); }
+
+  // Smart typing (IKSettings m_bSmartTyping): auto space after punctuation,
+  // capital letter at start of sentence etc. Also toggled by the smart typing
+  // key of QWERTY overlay.
+  void setSmartTyping(bool enable);
+  IKUnicode *getUnicode(void) { return &m_unicode; } // cache statistics
+
+  // Word prediction: IK_REPORT_TYPE_PREDICT keys (overlay cells or switches)
+  // type the rest of the n-th most likely word for what is being typed, then
+  // a space. Dictionary is generated by tools/ik_dict.py and must stay valid.
+  // Current completions can be shown with getPredict()->getWord().
+  bool setDictionary(uint8_t const *dict) {
+    m_predict.clear();
+    return m_predict.setDictionary(dict);
+  }
+  IKPredict *getPredict(void) { return &m_predict; }
+
   //--------------------------------------------------------------------+
   // Function named following IKDevice in OpenIKeys
   //--------------------------------------------------------------------+
@@ -84,7 +351,12 @@ public:
   bool PostCommand(uint8_t *command);
   void PostDelay(uint8_t msec);
   void PostSetLED(uint8_t number, uint8_t value);
-  void PostKey(int code, int direction, int delayAfter = 0);
+  void PostKey(int code, int direction, int delayAfter = 0,
+               bool record = true);
+  bool PostUnicode(uint32_t code_point);
+  bool PostPrediction(uint8_t index);
+  void PostTap(uint8_t code, bool shift);
+  bool PostChord(ik_report_keyboard_t const *key);
   void PostLiftAllModifiers(void);
   void PostCPRefresh();
   void PostReportDataToControlPanel(bool bForce = false);
@@ -93,6 +365,7 @@ public:
   void OnToggle(int newValue);
   void OnSwitch(int nswitch, int state);
   void OnSensorChange(int sensor, int value);
+  bool FilterSensor(uint8_t sensor, uint8_t value, int *filtered);
   void StoreEEProm(uint8_t data, uint8_t add_lsb, uint8_t add_msb);
   void ProcessInput(uint8_t const *data, uint8_t len);
 
@@ -103,9 +376,15 @@ public:
   void OnMembraneRelease(int x, int y);
   void OnCorrectSwitch(int switchnum);
   void DoCorrect();
+  void ScheduleCorrect(uint32_t interval);
+  void FetchEEProm(uint32_t now);
+  void SuspectEventLoss(void);
   void OnCorrectMembrane(int x, int y);
   void OnCorrectDone();
 
+  void ProcessKeystrokes(uint32_t now);
+  void ProcessMacro(uint32_t now);
+  bool SetKeystrokeKey(uint8_t code, bool down);
   void ResetKeyboard(void);
   void ResetMouse(void);
 
@@ -123,7 +402,9 @@ public:
   void LongKeySound();
   void KeySound(int msLength);
   void KeySoundVol(int msLength, int volume = -1);
-  void InterpretRaw();
+  void InterpretMembrane(uint8_t row, uint8_t col, uint8_t state);
+  void InterpretSwitch(uint8_t nsw, uint8_t state);
+  void InterpretRaw(void); // deprecated, changes are interpreted per event
 
   void hid_reprot_received_cb(uint8_t dev_addr, uint8_t instance,
                               uint8_t const *report, uint16_t len);
@@ -135,10 +416,17 @@ private:
   membrane_callback_t _membrane_cb;
   switch_callback_t _switch_cb;
   toggle_callback_t _toggle_cb;
+  scan_callback_t _scan_cb;
 
   IKOverlay *_custom_overlay;
   uint32_t _custom_overlay_count;
 
+  // setCustomOverlay() request, copied by ApplyCustomOverlay()
+  IKOverlay *_custom_overlay_req;
+  uint32_t _custom_overlay_req_count;
+  volatile uint32_t _custom_overlay_seq; // request seqlock, odd while written
+  uint32_t _custom_overlay_applied;      // _custom_overlay_seq in use
+
   //------------- From OpenIKeys -------------//
 
   int m_currentLevel;
@@ -147,53 +435,187 @@ private:
   uint32_t m_lastLEDTime;
   uint32_t m_delayUntil;
   uint32_t m_nextCorrect;
+  uint32_t m_correctInterval;
+  bool m_correctPending;
+  bool m_correcting; // applying correction events, no key sound
 
   int m_toggle; // on/off switch
   int m_sensors[IK_NUM_SENSORS];
+  uint8_t m_sensorHistory[IK_NUM_SENSORS][3]; // last 3 raw readings
+  uint8_t m_sensorReadings[IK_NUM_SENSORS];   // non-zero once history is filled
 
   int m_lastSwitch;
 
   //  overlay recognition
-  int m_lastOverlay;
-  uint32_t m_lastOverlayTime;
+  IKRecognizer m_recognizer;
   int m_currentOverlay;
 
   //  reading the eeprom
   eeprom_t m_eepromData;
-  unsigned int m_eepromRequestTime[sizeof(eeprom_t)];
-  bool m_eepromDataValid[sizeof(eeprom_t)];
+  uint64_t m_eepromDataValid; // 1 bit per byte of eeprom_t
+  uint64_t m_eepromInflight;  // requested, waiting for reply
+  uint32_t m_eepromRequestTime[sizeof(eeprom_t)];
+  uint8_t m_eepromRetry[sizeof(eeprom_t)];
   bool m_bEepromValid;
+  bool m_bSerialChecked;
 
-  //  for correction
-  uint8_t m_membranePressedInCorrectMode[IK_RESOLUTION_X][IK_RESOLUTION_Y];
-  uint8_t m_switchesPressedInCorrectMode[IK_NUM_SWITCHES];
+  //  sensor calibration cache
+  IKCache m_cache;
 
-  uint8_t m_last_membrane[IK_RESOLUTION_X][IK_RESOLUTION_Y];
-  uint8_t m_last_switches[IK_NUM_SWITCHES];
+  //  settings changed from overlay, written by saveChangedSettings()
+  volatile uint32_t m_settingsChangeCount;
+  volatile uint32_t m_settingsChangeTime;
+  uint32_t m_settingsSavedCount;
+  uint32_t m_flashWriteTime;
+
+  //  for correction: 1 bit per cell (column) for each row, 1 bit per switch
+  uint32_t m_membranePressedInCorrectMode[IK_RESOLUTION_Y];
+  uint8_t m_switchesPressedInCorrectMode;
 
   uint8_t m_membrane[IK_RESOLUTION_X][IK_RESOLUTION_Y];
   uint8_t m_switches[IK_NUM_SWITCHES];
 
+  ik_switch_overlay_t m_switchOverlays[MAX_SWITCH_OVERLAYS];
+  uint8_t m_switchOverlay; // selected
+
+  //  switch overlays set by the sketch, copied by ApplySwitchOverlays()
+  struct {
+    ik_switch_overlay_t overlays[MAX_SWITCH_OVERLAYS];
+    uint8_t select;
+  } m_switchOverlayRequest;
+  volatile uint32_t m_switchOverlaySeq; // request seqlock, odd while written
+  uint32_t m_switchOverlayApplied;      // m_switchOverlaySeq of current table
+
   uint8_t m_firmwareVersionMajor;
   uint8_t m_firmwareVersionMinor;
 
-  int m_lastCodeUp;
-  bool m_bShifted;
-
-  IKModifier m_modShift;
-  IKModifier m_modAlt;
-  IKModifier m_modControl;
-  IKModifier m_modCommand;
+  bool m_bShifted; // shift held by keystroke queue
 
-  IKModifier m_mouseDown;
+  //  latched/locked modifiers and mouse click hold
+  IKModifiers m_modifiers;
 
   tu_fifo_t _cmd_ff;
   OSAL_MUTEX_DEF(_cmd_ff_mutex);
   uint8_t _cmd_ff_buf[8 * IK_CMD_FIFO_SIZE];
 
+  //  keystroke queue: code, direction, delay after (16-bit)
+  tu_fifo_t _key_ff;
+  OSAL_MUTEX_DEF(_key_ff_mutex);
+  uint8_t _key_ff_buf[4 * IK_KEYSTROKE_FIFO_SIZE];
+  uint32_t m_keystrokeNext;    // time of next event
+  uint32_t m_keystrokeStart;   // start of current burst, 0 if idle
+  uint32_t m_keystrokeHeld[8]; // universal codes put down by the queue
+  uint32_t m_typedCount;
+  uint32_t m_typingTime;
+
+  //  macro playback, paced by keyboard report polling
+  IKMacro m_macro;
+  volatile uint32_t m_kbSeq;      // m_kbPublished seqlock, odd while written
+  volatile uint32_t m_kbTakenSeq; // m_kbSeq of last copied report
+  uint32_t m_macroSeq;            // m_kbSeq of last macro output
+  uint32_t m_macroTime;
+  bool m_bRebuilding;
+
+  //  unicode input
+  IKUnicode m_unicode;
+  uint16_t m_unicodeLead; // pending high surrogate of IK_CMD_KEYBOARD_UNICODE
+
+  //  smart typing, keys typed through keystroke queue are not released
+  IKSmartTyping m_smartTyping;
+  uint32_t m_smartKeys[IK_KEY_ID_COUNT / 32];
+
+  //  word prediction
+  IKPredict m_predict;
+
+  //  incremental HID report: number of pressed cells for each key, report is
+  //  updated only when a key count changes from/to zero
+  uint16_t m_keyCellCount[IK_KEY_ID_COUNT]; // a key may cover all 24x24 cells
+  uint8_t m_keycodeCount[IK_NKRO_KEYCODE_COUNT];
+  uint8_t m_modifierCount[8];
+  uint8_t m_mouseButtonCount[8];
+  int16_t m_mouseX; // sum of held mouse keys direction
+  int16_t m_mouseY;
+  IKMouse m_mouse;
+  uint8_t m_keycodeDown; // number of keycodes currently down
+  ik_nkro_keyboard_report_t m_kbReport;
+  ik_nkro_keyboard_report_t m_kbPublished; // m_kbReport as seen by core0
+
+  //  key repeat, timer is shared with other time based features
+  IKTimer m_timer;
+  uint8_t m_repeatFlags[IK_KEY_ID_COUNT];
+  uint8_t m_repeatLatchCount;
+
+  //  response rate, required lift off and debounce
+  IKFilter m_filter;
+  ik_nkro_keyboard_report_t m_kbSentReport; // last by getKeyboardReport()
+  uint8_t m_mouseSentButtons;                // last by getMouseReport()
+
+  //  touch mode: keys pressed by current touches
+  IKTouch m_touch;
+  bool m_touchMode;
+  volatile bool m_touchModeRequest; // from setTouchMode()
+  volatile bool m_mouseAccessTrackpad; // from setMouseAccessTrackpad()
+  bool m_mouseAccessTrackpadApplied;
+  uint8_t m_touchKeys[IK_TOUCH_MAX];
+  uint8_t m_touchKeyCount;
+
+  //  trackpad
+  uint8_t m_trackpadMode;
+  bool m_tpTouching;
+  uint16_t m_tpLastX; // last centroid in 1/256 cell
+  uint16_t m_tpLastY;
+  uint16_t m_tpAbsX;
+  uint16_t m_tpAbsY;
+
+  //  scanning
+  IKScan m_scan;
+  uint8_t m_scanSwitch; // select switch, 0 if scanning is off
+  uint8_t m_scanStepSwitch;
+  uint8_t m_scanLed; // lit scan indicator LED, 0 if none
+  uint8_t m_scanKey; // selected key being pressed
+  volatile uint16_t m_scanRequest; // select | step << 8 from setScanSwitch()
+  volatile uint8_t m_scanRequestCount;
+  uint8_t m_scanAppliedCount;
+
   bool Start(void);
   void Reset(void);
 
+  ik_report_t const *GetKeyReport(uint8_t key_id);
+  void InterpretReport(ik_report_t const *report);
+  void KeyDown(uint8_t key_id);
+  void KeyUp(uint8_t key_id);
+  void OnFilterResult(uint8_t key_id, uint8_t result);
+  void OutputKeyDown(uint8_t key_id);
+  void OutputKeyUp(uint8_t key_id);
+  bool SmartTypeKey(ik_report_keyboard_t const *key);
+  void RecordTyped(uint8_t keycode, bool shifted);
+  void ClearTyped(void);
+  void ReleaseKey(uint8_t key_id);
+  void StartRepeat(uint8_t key_id);
+  void StopLatchedRepeat(void);
+  void OnRepeatTimer(uint8_t key_id);
+  void OnTimer(uint16_t id);
+  void UpdateKeyReport(ik_report_t const *report, bool down);
+  void ClearHIDReport(void);
+  void RebuildHIDReport(void);
+  void UpdateTouches(void);
+  void UpdateTouchKeys(uint8_t count);
+  void UpdateTrackpad(IKOverlay *overlay);
+  void ApplyScanSwitch(void);
+  void ApplySwitchOverlays(void);
+  void ApplyTouchMode(void);
+  void ApplyMouseAccessTrackpad(void);
+  void ApplyCustomOverlay(void);
+  bool IsScanSwitch(int nswitch);
+  void OnScanSwitch(int nswitch);
+  void OnScanSelect(uint8_t key_id);
+  void UpdateScan(void);
+  void UpdateScanIndicator(bool sound);
+  bool isReportReady(void);
+  void PublishKeyboardReport(void);
+  void BuildKeyboardReport(ik_nkro_keyboard_report_t *kb_report);
+  void BuildMouseReport(hid_mouse_report_t *mouse_report);
+
   // ezusb
   bool ezusb_StartDevice(void);
   bool ezusb_DownloadIntelHex(INTEL_HEX_RECORD const *record);
@@ -0,0 +1,140 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "SdFat.h"
+
+#include "IKCache.h"
+
+#define CACHE_MAGIC 0x31434b49 // "IKC1"
+
+static bool isValidEntry(eeprom_t const *eeprom) {
+  return eeprom->serialnumber[0] == 'C' && eeprom->serialnumber[1] == '-';
+}
+
+IKCache::IKCache() {
+  _vol = NULL;
+  memset(&_cache, 0, sizeof(_cache));
+  _seq = 0;
+  _savedSeq = 0;
+}
+
+void IKCache::begin(FatVolume *vol) {
+  _vol = vol;
+  memset(&_cache, 0, sizeof(_cache));
+  if (_vol == NULL) {
+    return;
+  }
+
+  File32 file = _vol->open(IK_CACHE_FILENAME, O_RDONLY);
+  if (!file) {
+    return; // empty cache
+  }
+
+  int const count = file.read(&_cache, sizeof(_cache));
+  file.close();
+
+  if (count != (int)sizeof(_cache) || _cache.magic != CACHE_MAGIC) {
+    memset(&_cache, 0, sizeof(_cache));
+  }
+}
+
+bool IKCache::getRecent(eeprom_t *eeprom) {
+  if (!isValidEntry(&_cache.entries[0])) {
+    return false;
+  }
+
+  *eeprom = _cache.entries[0];
+  return true;
+}
+
+bool IKCache::find(uint8_t const *serial, eeprom_t *eeprom) {
+  for (uint8_t i = 0; i < IK_CACHE_ENTRIES; i++) {
+    eeprom_t const *entry = &_cache.entries[i];
+    if (isValidEntry(entry) &&
+        0 == memcmp(entry->serialnumber, serial, IK_EEPROM_SN_SIZE)) {
+      *eeprom = *entry;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void IKCache::save(eeprom_t const *eeprom) {
+  if (_vol == NULL || !isValidEntry(eeprom)) {
+    return;
+  }
+
+  // already most recent and up to date
+  if (_cache.magic == CACHE_MAGIC &&
+      0 == memcmp(&_cache.entries[0], eeprom, sizeof(eeprom_t))) {
+    return;
+  }
+
+  // remove old entry of this board (or drop the last one), then put it first
+  uint8_t pos = IK_CACHE_ENTRIES - 1;
+  for (uint8_t i = 0; i < IK_CACHE_ENTRIES; i++) {
+    if (0 == memcmp(_cache.entries[i].serialnumber, eeprom->serialnumber,
+                    IK_EEPROM_SN_SIZE)) {
+      pos = i;
+      break;
+    }
+  }
+
+  _seq = _seq + 1;
+  __sync_synchronize();
+  memmove(&_cache.entries[1], &_cache.entries[0], pos * sizeof(eeprom_t));
+  _cache.entries[0] = *eeprom;
+  _cache.magic = CACHE_MAGIC;
+  __sync_synchronize();
+  _seq = _seq + 1;
+}
+
+void IKCache::flush(void) {
+  if (_vol == NULL || _seq == _savedSeq) {
+    return;
+  }
+
+  cache_file_t cache;
+  uint32_t seq;
+  do {
+    seq = _seq;
+    __sync_synchronize();
+    cache = _cache;
+    __sync_synchronize();
+  } while ((seq & 1) || seq != _seq);
+
+  // best effort, not retried if the file can't be written
+  _savedSeq = seq;
+
+  File32 file = _vol->open(IK_CACHE_FILENAME, O_WRONLY | O_CREAT | O_TRUNC);
+  if (!file) {
+    return;
+  }
+
+  file.write(&cache, sizeof(cache));
+  file.close();
+}
@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKCACHE_H
+#define ADAFRUIT_INTELLIKEYS_IKCACHE_H
+
+#include "intellikeysdefs.h"
+
+class FatVolume;
+
+#define IK_CACHE_FILENAME "/ik_cache.bin"
+
+// Number of boards remembered, least recently used one is dropped
+#define IK_CACHE_ENTRIES 4
+
+// Persistent cache of IntelliKeys EEPROM (serial number and sensor
+// calibration) in the flash filesystem. Entries are kept most recently used
+// first, file is only rewritten when content or order changes.
+//
+// The file is only accessed by begin() and flush(), from the core that owns
+// the flash volume. The driver core looks up and updates the copy in RAM,
+// flush() takes a consistent snapshot of it (seqlock).
+class IKCache {
+public:
+  IKCache();
+
+  // Load the file
+  void begin(FatVolume *vol);
+
+  // Most recently used board, a good guess before serial is read
+  bool getRecent(eeprom_t *eeprom);
+
+  // Find board by serial number (IK_EEPROM_SN_SIZE bytes)
+  bool find(uint8_t const *serial, eeprom_t *eeprom);
+
+  // Store board as most recently used, written by the next flush()
+  void save(eeprom_t const *eeprom);
+
+  // Content changed since last flush()
+  bool isDirty(void) { return _vol && _seq != _savedSeq; }
+
+  // Write the file if it has changed
+  void flush(void);
+
+private:
+  typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    eeprom_t entries[IK_CACHE_ENTRIES];
+  } cache_file_t;
+
+  FatVolume *_vol;
+  cache_file_t _cache;
+  volatile uint32_t _seq; // _cache seqlock, odd while updated by save()
+  uint32_t _savedSeq;     // _seq of last written content
+};
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "IKFilter.h"
+#include "IKSettings.h"
+
+IKFilter::IKFilter(IKTimer *timer, uint16_t timer_base) {
+  _timer = timer;
+  _timer_base = timer_base;
+  memset(_state, STATE_IDLE, sizeof(_state));
+  memset(_chord, 0, sizeof(_chord));
+  _down_count = 0;
+}
+
+void IKFilter::clear(void) {
+  for (uint16_t id = 0; id < IK_KEY_ID_COUNT; id++) {
+    if (_state[id] == STATE_DWELL || _state[id] == STATE_RELEASING) {
+      _timer->cancel(_timer_base + id);
+    }
+  }
+  memset(_state, STATE_IDLE, sizeof(_state));
+  memset(_chord, 0, sizeof(_chord));
+  _down_count = 0;
+}
+
+void IKFilter::drop(uint8_t key_id) {
+  uint8_t const state = _state[key_id];
+  if (state == STATE_DWELL || state == STATE_RELEASING) {
+    _timer->cancel(_timer_base + key_id);
+  }
+  if (state >= STATE_DOWN && !isChord(key_id)) {
+    _down_count--;
+  }
+  _state[key_id] = STATE_IDLE;
+}
+
+// Response Rate steps below the highest setting
+static uint32_t responseSlowness(void) {
+  int rate = IKSettings::GetSettings()->m_iResponseRate;
+  if (rate < kSettingsRateLow) {
+    rate = kSettingsRateLow;
+  } else if (rate > kSettingsRateHigh) {
+    rate = kSettingsRateHigh;
+  }
+
+  return (uint32_t)(kSettingsRateHigh - rate);
+}
+
+uint32_t IKFilter::dwellTime(void) {
+  return responseSlowness() * IK_FILTER_DWELL_MAX /
+         (kSettingsRateHigh - kSettingsRateLow);
+}
+
+uint32_t IKFilter::debounceTime(void) {
+  return IK_FILTER_DEBOUNCE_MIN +
+         responseSlowness() *
+             (IK_FILTER_DEBOUNCE_MAX - IK_FILTER_DEBOUNCE_MIN) /
+             (kSettingsRateHigh - kSettingsRateLow);
+}
+
+// Required lift off: another key is down, chord keys are never blocked
+bool IKFilter::isBlocked(uint8_t key_id) {
+  return _down_count && !isChord(key_id) &&
+         IKSettings::GetSettings()->m_bRequiredLiftOff;
+}
+
+uint8_t IKFilter::accept(uint8_t key_id) {
+  if (isBlocked(key_id)) {
+    _state[key_id] = STATE_IGNORED;
+    return IK_FILTER_NONE;
+  }
+
+  _state[key_id] = STATE_DOWN;
+  if (!isChord(key_id)) {
+    _down_count++;
+  }
+  return IK_FILTER_PRESS;
+}
+
+uint8_t IKFilter::press(uint8_t key_id, uint32_t now, bool chord) {
+  switch (_state[key_id]) {
+  case STATE_IDLE: {
+    uint32_t const mask = 1ul << (key_id % 32);
+    if (chord) {
+      _chord[key_id / 32] |= mask;
+    } else {
+      _chord[key_id / 32] &= ~mask;
+    }
+
+    uint32_t const dwell = dwellTime();
+    if (dwell == 0) {
+      return accept(key_id);
+    }
+
+    if (isBlocked(key_id)) {
+      _state[key_id] = STATE_IGNORED;
+      return IK_FILTER_NONE;
+    }
+
+    _state[key_id] = STATE_DWELL;
+    _timer->start(_timer_base + key_id, now + dwell);
+    return IK_FILTER_NONE;
+  }
+
+  case STATE_RELEASING:
+    // chatter: release is not confirmed, key is still down
+    _timer->cancel(_timer_base + key_id);
+    _state[key_id] = STATE_DOWN;
+    return IK_FILTER_NONE;
+
+  default:
+    return IK_FILTER_NONE;
+  }
+}
+
+uint8_t IKFilter::release(uint8_t key_id, uint32_t now) {
+  switch (_state[key_id]) {
+  case STATE_DWELL:
+    // too short, not accepted
+    _timer->cancel(_timer_base + key_id);
+    _state[key_id] = STATE_IDLE;
+    return IK_FILTER_NONE;
+
+  case STATE_IGNORED:
+    _state[key_id] = STATE_IDLE;
+    return IK_FILTER_NONE;
+
+  case STATE_DOWN:
+    _state[key_id] = STATE_RELEASING;
+    _timer->start(_timer_base + key_id, now + debounceTime());
+    return IK_FILTER_NONE;
+
+  default:
+    return IK_FILTER_NONE;
+  }
+}
+
+uint8_t IKFilter::timeout(uint8_t key_id) {
+  switch (_state[key_id]) {
+  case STATE_DWELL:
+    return accept(key_id);
+
+  case STATE_RELEASING:
+    _state[key_id] = STATE_IDLE;
+    if (!isChord(key_id)) {
+      _down_count--;
+    }
+    return IK_FILTER_RELEASE;
+
+  default:
+    return IK_FILTER_NONE;
+  }
+}
@@ -0,0 +1,100 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKFILTER_H
+#define ADAFRUIT_INTELLIKEYS_IKFILTER_H
+
+#include "IKOverlay.h"
+#include "IKTimer.h"
+
+// Dwell time (ms) a key must be held before accepted with the lowest Response
+// Rate setting. Highest setting accepts keys right away.
+#define IK_FILTER_DWELL_MAX 2000
+
+// Release is confirmed only if the key is not pressed again within the
+// debounce time (ms), chattering of a shaky press is absorbed. It follows the
+// Response Rate from MAX at the lowest setting down to MIN at the highest, so
+// that fast repeated taps are not merged.
+#define IK_FILTER_DEBOUNCE_MAX 20
+#define IK_FILTER_DEBOUNCE_MIN 5
+
+// Result of filter input
+enum { IK_FILTER_NONE = 0, IK_FILTER_PRESS, IK_FILTER_RELEASE };
+
+// Input conditioning between raw key press/release (from membrane cells) and
+// report output, following IKSettings:
+// - m_iResponseRate: key must be held for a dwell time before accepted
+// - m_bRequiredLiftOff: no key is accepted while another accepted key is down,
+//   key pressed meanwhile is ignored until it is lifted. Chord keys (modifier
+//   and latching keys, see press()) are exempt: they are always accepted and
+//   do not block other keys, so that e.g Shift + letter still works.
+// - release debounce (IK_FILTER_DEBOUNCE_MIN - IK_FILTER_DEBOUNCE_MAX)
+// Deadlines are IKTimer timers (base + key id), so that only keys in
+// transition cost anything.
+class IKFilter {
+public:
+  IKFilter(IKTimer *timer, uint16_t timer_base);
+
+  void clear(void);
+
+  // Forget a key without output, e.g it is no longer held after the key
+  // mapping changed
+  void drop(uint8_t key_id);
+
+  // Raw key changes and expired timer, return IK_FILTER_PRESS or
+  // IK_FILTER_RELEASE if key output should change. Chord is true for a key
+  // that is held while typing other keys (modifier, click hold).
+  uint8_t press(uint8_t key_id, uint32_t now, bool chord = false);
+  uint8_t release(uint8_t key_id, uint32_t now);
+  uint8_t timeout(uint8_t key_id);
+
+  bool isDown(uint8_t key_id) { return _state[key_id] >= STATE_DOWN; }
+
+private:
+  enum {
+    STATE_IDLE = 0,
+    STATE_IGNORED, // pressed but not accepted due to required lift off
+    STATE_DWELL,   // pressed, waiting for dwell time
+    STATE_DOWN,    // accepted
+    STATE_RELEASING, // released, waiting for debounce time
+  };
+
+  IKTimer *_timer;
+  uint16_t _timer_base;
+
+  uint8_t _state[IK_KEY_ID_COUNT];
+  uint32_t _chord[IK_KEY_ID_COUNT / 32]; // 1 bit per key, see press()
+  uint8_t _down_count; // non-chord keys in STATE_DOWN or STATE_RELEASING
+
+  bool isChord(uint8_t key_id) {
+    return (_chord[key_id / 32] >> (key_id % 32)) & 1u;
+  }
+  bool isBlocked(uint8_t key_id);
+
+  uint8_t accept(uint8_t key_id);
+  uint32_t dwellTime(void);
+  uint32_t debounceTime(void);
+};
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKKEYCODE_H
+#define ADAFRUIT_INTELLIKEYS_IKKEYCODE_H
+
+#include "IKOverlay.h"
+#include "IKUniversal.h"
+#include "class/hid/hid.h"
+
+// Universal code of each HID keyboard usage. Universal codes shared by two
+// keys (F13 and Print Screen etc.) map to their PC key. Codes without a key
+// (mouse, level, setup ...) are not listed.
+constexpr uint8_t IK_UNIVERSAL_HID_MAP[][2] = {
+    {UNIVERSAL_F1, HID_KEY_F1},
+    {UNIVERSAL_F2, HID_KEY_F2},
+    {UNIVERSAL_F3, HID_KEY_F3},
+    {UNIVERSAL_F4, HID_KEY_F4},
+    {UNIVERSAL_F5, HID_KEY_F5},
+    {UNIVERSAL_F6, HID_KEY_F6},
+    {UNIVERSAL_F7, HID_KEY_F7},
+    {UNIVERSAL_F8, HID_KEY_F8},
+    {UNIVERSAL_F9, HID_KEY_F9},
+    {UNIVERSAL_F10, HID_KEY_F10},
+    {UNIVERSAL_F11, HID_KEY_F11},
+    {UNIVERSAL_F12, HID_KEY_F12},
+    {UNIVERSAL_PRINT_SCREEN, HID_KEY_PRINT_SCREEN},
+    {UNIVERSAL_SCROLL_LOCK, HID_KEY_SCROLL_LOCK},
+    {UNIVERSAL_PAUSE, HID_KEY_PAUSE},
+
+    {UNIVERSAL_NUMPAD_0, HID_KEY_KEYPAD_0},
+    {UNIVERSAL_NUMPAD_1, HID_KEY_KEYPAD_1},
+    {UNIVERSAL_NUMPAD_2, HID_KEY_KEYPAD_2},
+    {UNIVERSAL_NUMPAD_3, HID_KEY_KEYPAD_3},
+    {UNIVERSAL_NUMPAD_4, HID_KEY_KEYPAD_4},
+    {UNIVERSAL_NUMPAD_5, HID_KEY_KEYPAD_5},
+    {UNIVERSAL_NUMPAD_6, HID_KEY_KEYPAD_6},
+    {UNIVERSAL_NUMPAD_7, HID_KEY_KEYPAD_7},
+    {UNIVERSAL_NUMPAD_8, HID_KEY_KEYPAD_8},
+    {UNIVERSAL_NUMPAD_9, HID_KEY_KEYPAD_9},
+    {UNIVERSAL_NUMPAD_ADD, HID_KEY_KEYPAD_ADD},
+    {UNIVERSAL_NUMPAD_SUBTRACT, HID_KEY_KEYPAD_SUBTRACT},
+    {UNIVERSAL_NUMPAD_MULTIPLY, HID_KEY_KEYPAD_MULTIPLY},
+    {UNIVERSAL_NUMPAD_DIVIDE, HID_KEY_KEYPAD_DIVIDE},
+    {UNIVERSAL_NUMPAD_EQUAL, HID_KEY_KEYPAD_EQUAL},
+    {UNIVERSAL_NUMPAD_ENTER, HID_KEY_KEYPAD_ENTER},
+    {UNIVERSAL_NUMPAD_DECIMAL, HID_KEY_KEYPAD_DECIMAL},
+
+    {UNIVERSAL_SPACE, HID_KEY_SPACE},
+    {UNIVERSAL_INSERT, HID_KEY_INSERT},
+    {UNIVERSAL_DELETE, HID_KEY_DELETE},
+    {UNIVERSAL_UP_ARROW, HID_KEY_ARROW_UP},
+    {UNIVERSAL_DOWN_ARROW, HID_KEY_ARROW_DOWN},
+    {UNIVERSAL_LEFT_ARROW, HID_KEY_ARROW_LEFT},
+    {UNIVERSAL_RIGHT_ARROW, HID_KEY_ARROW_RIGHT},
+    {UNIVERSAL_HOME, HID_KEY_HOME},
+    {UNIVERSAL_END, HID_KEY_END},
+    {UNIVERSAL_PAGE_UP, HID_KEY_PAGE_UP},
+    {UNIVERSAL_PAGE_DOWN, HID_KEY_PAGE_DOWN},
+    {UNIVERSAL_COMMA, HID_KEY_COMMA},
+    {UNIVERSAL_MINUS, HID_KEY_MINUS},
+    {UNIVERSAL_PERIOD, HID_KEY_PERIOD},
+    {UNIVERSAL_SLASH, HID_KEY_SLASH},
+
+    {UNIVERSAL_0, HID_KEY_0},
+    {UNIVERSAL_1, HID_KEY_1},
+    {UNIVERSAL_2, HID_KEY_2},
+    {UNIVERSAL_3, HID_KEY_3},
+    {UNIVERSAL_4, HID_KEY_4},
+    {UNIVERSAL_5, HID_KEY_5},
+    {UNIVERSAL_6, HID_KEY_6},
+    {UNIVERSAL_7, HID_KEY_7},
+    {UNIVERSAL_8, HID_KEY_8},
+    {UNIVERSAL_9, HID_KEY_9},
+    {UNIVERSAL_SEMICOLON, HID_KEY_SEMICOLON},
+    {UNIVERSAL_EQUALS, HID_KEY_EQUAL},
+    {UNIVERSAL_TILDE, HID_KEY_GRAVE},
+    {UNIVERSAL_QUOTE, HID_KEY_APOSTROPHE},
+
+    {UNIVERSAL_A, HID_KEY_A},
+    {UNIVERSAL_B, HID_KEY_B},
+    {UNIVERSAL_C, HID_KEY_C},
+    {UNIVERSAL_D, HID_KEY_D},
+    {UNIVERSAL_E, HID_KEY_E},
+    {UNIVERSAL_F, HID_KEY_F},
+    {UNIVERSAL_G, HID_KEY_G},
+    {UNIVERSAL_H, HID_KEY_H},
+    {UNIVERSAL_I, HID_KEY_I},
+    {UNIVERSAL_J, HID_KEY_J},
+    {UNIVERSAL_K, HID_KEY_K},
+    {UNIVERSAL_L, HID_KEY_L},
+    {UNIVERSAL_M, HID_KEY_M},
+    {UNIVERSAL_N, HID_KEY_N},
+    {UNIVERSAL_O, HID_KEY_O},
+    {UNIVERSAL_P, HID_KEY_P},
+    {UNIVERSAL_Q, HID_KEY_Q},
+    {UNIVERSAL_R, HID_KEY_R},
+    {UNIVERSAL_S, HID_KEY_S},
+    {UNIVERSAL_T, HID_KEY_T},
+    {UNIVERSAL_U, HID_KEY_U},
+    {UNIVERSAL_V, HID_KEY_V},
+    {UNIVERSAL_W, HID_KEY_W},
+    {UNIVERSAL_X, HID_KEY_X},
+    {UNIVERSAL_Y, HID_KEY_Y},
+    {UNIVERSAL_Z, HID_KEY_Z},
+    {UNIVERSAL_LEFT_BRACKET, HID_KEY_BRACKET_LEFT},
+    {UNIVERSAL_BACKSLASH, HID_KEY_BACKSLASH},
+    {UNIVERSAL_RIGHT_BRACKET, HID_KEY_BRACKET_RIGHT},
+
+    {UNIVERSAL_ENTER, HID_KEY_ENTER},
+    {UNIVERSAL_ESCAPE, HID_KEY_ESCAPE},
+    {UNIVERSAL_TAB, HID_KEY_TAB},
+    {UNIVERSAL_BACKSPACE, HID_KEY_BACKSPACE},
+    {UNIVERSAL_CAPS_LOCK, HID_KEY_CAPS_LOCK},
+    {UNIVERSAL_NUM_LOCK, HID_KEY_NUM_LOCK},
+
+    {UNIVERSAL_SHIFT, HID_KEY_SHIFT_LEFT},
+    {UNIVERSAL_RIGHT_SHIFT, HID_KEY_SHIFT_RIGHT},
+    {UNIVERSAL_CONTROL, HID_KEY_CONTROL_LEFT},
+    {UNIVERSAL_RIGHT_CONTROL, HID_KEY_CONTROL_RIGHT},
+    {UNIVERSAL_ALT, HID_KEY_ALT_LEFT},
+    {UNIVERSAL_ALTGR, HID_KEY_ALT_RIGHT},
+    {UNIVERSAL_COMMAND, HID_KEY_GUI_LEFT},
+};
+
+// Both directions of IK_UNIVERSAL_HID_MAP as flat tables built at compile
+// time, 0 if there is no counterpart. Lookup is a single load.
+typedef struct {
+  uint8_t hid[256];       // universal code -> HID usage
+  uint8_t universal[256]; // HID usage -> universal code
+} ik_universal_table_t;
+
+constexpr ik_universal_table_t ik_universal_table_build(void) {
+  ik_universal_table_t table = {};
+  for (auto const &map : IK_UNIVERSAL_HID_MAP) {
+    table.hid[map[0]] = map[1];
+    table.universal[map[1]] = map[0];
+  }
+  return table;
+}
+
+// Each universal code and HID usage must appear only once in the map
+constexpr bool ik_universal_map_unique(void) {
+  uint16_t const count =
+      sizeof(IK_UNIVERSAL_HID_MAP) / sizeof(IK_UNIVERSAL_HID_MAP[0]);
+  for (uint16_t i = 0; i < count; i++) {
+    for (uint16_t j = i + 1; j < count; j++) {
+      if (IK_UNIVERSAL_HID_MAP[i][0] == IK_UNIVERSAL_HID_MAP[j][0] ||
+          IK_UNIVERSAL_HID_MAP[i][1] == IK_UNIVERSAL_HID_MAP[j][1]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+static_assert(ik_universal_map_unique(), "duplicate in IK_UNIVERSAL_HID_MAP");
+
+inline constexpr ik_universal_table_t ik_universal_table =
+    ik_universal_table_build();
+
+constexpr uint8_t ik_universal_to_hid(uint8_t code) {
+  return ik_universal_table.hid[code];
+}
+
+constexpr uint8_t ik_hid_to_universal(uint8_t usage) {
+  return ik_universal_table.universal[usage];
+}
+
+// Keyboard report of a universal code: modifier keys set their modifier bit,
+// others their keycode. Return false if code is not a key.
+static inline bool ik_universal_to_keyboard(uint8_t code,
+                                            ik_report_keyboard_t *report) {
+  uint8_t const usage = ik_universal_to_hid(code);
+  report->modifier = 0;
+  report->keycode = 0;
+
+  if (usage >= HID_KEY_CONTROL_LEFT && usage <= HID_KEY_GUI_RIGHT) {
+    report->modifier = (uint8_t)(1u << (usage - HID_KEY_CONTROL_LEFT));
+  } else {
+    report->keycode = usage;
+  }
+
+  return usage != 0;
+}
+
+#endif
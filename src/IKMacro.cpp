@@ -0,0 +1,133 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "IKMacro.h"
+#include "class/hid/hid.h"
+
+static ik_macro_t const stdMacros[IK_MACRO_STD_COUNT] = {
+    [IK_MACRO_WWW] = {"www.", NULL, 0}, [IK_MACRO_COM] = {".com", NULL, 0},
+    [IK_MACRO_NET] = {".net", NULL, 0}, [IK_MACRO_GOV] = {".gov", NULL, 0},
+    [IK_MACRO_EDU] = {".edu", NULL, 0}, [IK_MACRO_ORG] = {".org", NULL, 0},
+};
+
+static uint8_t const asciiKeycode[128][2] = {HID_ASCII_TO_KEYCODE};
+
+IKMacro::IKMacro() {
+  _custom = NULL;
+  _custom_count = 0;
+  clear();
+}
+
+void IKMacro::clear(void) {
+  _head = _count = 0;
+  _macro = NULL;
+  _pos = 0;
+  _down = false;
+  _report.modifier = 0;
+  _report.keycode = 0;
+}
+
+bool IKMacro::asciiToKeyboard(char ch, ik_report_keyboard_t *report) {
+  uint8_t const c = (uint8_t)ch;
+  if (c >= 128 || asciiKeycode[c][1] == 0) {
+    return false;
+  }
+
+  report->modifier = asciiKeycode[c][0] ? KEYBOARD_MODIFIER_LEFTSHIFT : 0;
+  report->keycode = asciiKeycode[c][1];
+  return true;
+}
+
+ik_macro_t const *IKMacro::getMacro(uint8_t index) {
+  if (index < IK_MACRO_STD_COUNT) {
+    return &stdMacros[index];
+  }
+
+  if (index >= IK_MACRO_CUSTOM_BASE &&
+      index - IK_MACRO_CUSTOM_BASE < _custom_count) {
+    return &_custom[index - IK_MACRO_CUSTOM_BASE];
+  }
+
+  return NULL;
+}
+
+bool IKMacro::play(uint8_t index) {
+  if (getMacro(index) == NULL || _count >= IK_MACRO_QUEUE_SIZE) {
+    return false;
+  }
+
+  _queue[(_head + _count) % IK_MACRO_QUEUE_SIZE] = index;
+  _count++;
+  return true;
+}
+
+// Next key of playing macro, characters that cannot be typed are skipped
+bool IKMacro::getKey(ik_report_keyboard_t *report) {
+  if (_macro->text) {
+    while (_macro->text[_pos]) {
+      if (asciiToKeyboard(_macro->text[_pos++], report)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (_pos < _macro->count) {
+    *report = _macro->keys[_pos++];
+    return true;
+  }
+  return false;
+}
+
+bool IKMacro::next(ik_report_keyboard_t *report, bool *down) {
+  if (_down) {
+    // release before next key, same key may follow
+    _down = false;
+    *report = _report;
+    *down = false;
+    return true;
+  }
+
+  while (1) {
+    if (_macro == NULL) {
+      if (_count == 0) {
+        return false;
+      }
+      _macro = getMacro(_queue[_head]);
+      _head = (_head + 1) % IK_MACRO_QUEUE_SIZE;
+      _count--;
+      _pos = 0;
+      continue;
+    }
+
+    if (getKey(&_report)) {
+      _down = true;
+      *report = _report;
+      *down = true;
+      return true;
+    }
+
+    _macro = NULL; // done
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKMACRO_H
+#define ADAFRUIT_INTELLIKEYS_IKMACRO_H
+
+#include "IKOverlay.h"
+
+// Number of macro keys that can be pressed while one is playing
+#define IK_MACRO_QUEUE_SIZE 8
+
+// Standard macros, custom macros are numbered from IK_MACRO_CUSTOM_BASE
+enum {
+  IK_MACRO_WWW = 0,
+  IK_MACRO_COM,
+  IK_MACRO_NET,
+  IK_MACRO_GOV,
+  IK_MACRO_EDU,
+  IK_MACRO_ORG,
+  IK_MACRO_STD_COUNT
+};
+#define IK_MACRO_CUSTOM_BASE 128
+
+// Macro is either an ASCII string or a sequence of keys. Both are meant to be
+// const so that the pool stays in flash.
+typedef struct {
+  char const *text;                 // NULL for key sequence
+  ik_report_keyboard_t const *keys; // pressed and released one after another
+  uint8_t count;
+} ik_macro_t;
+
+// Macro pool and playback. Playback breaks macros into key down/up states,
+// the driver decides when the next state can be output.
+class IKMacro {
+public:
+  IKMacro();
+
+  // Custom macros, pool must stay valid (e.g const array)
+  void setCustomPool(ik_macro_t const *pool, uint8_t count) {
+    _custom = pool;
+    _custom_count = count;
+  }
+  ik_macro_t const *getMacro(uint8_t index);
+
+  void clear(void);
+
+  // Queue macro for playback, return false if it does not exist or queue is
+  // full
+  bool play(uint8_t index);
+  bool isPlaying(void) { return _macro != NULL || _count != 0; }
+
+  // Next key state to output, return false if there is none
+  bool next(ik_report_keyboard_t *report, bool *down);
+
+  // Key currently held down by playback
+  bool getHeldKey(ik_report_keyboard_t *report) {
+    *report = _report;
+    return _down;
+  }
+
+  // ASCII to keyboard report (US layout), return false if not typeable
+  static bool asciiToKeyboard(char ch, ik_report_keyboard_t *report);
+
+private:
+  ik_macro_t const *_custom;
+  uint8_t _custom_count;
+
+  uint8_t _queue[IK_MACRO_QUEUE_SIZE];
+  uint8_t _head;
+  uint8_t _count;
+
+  ik_macro_t const *_macro; // playing
+  uint16_t _pos;
+  bool _down;
+  ik_report_keyboard_t _report;
+
+  bool getKey(ik_report_keyboard_t *report);
+};
+
+#endif
@@ -4,88 +4,68 @@
  * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
  */
 
-#include "Arduino.h"
-
-#include "Adafruit_IntelliKeys.h"
 #include "IKModifier.h"
 
 #define IK_MODIFIER_CHANGE_DELAY 5
 
-void IKModifier::ToggleState() {
-  // skip if it is changed in the last 5ms
-  if (millis() - m_lastTime > IK_MODIFIER_CHANGE_DELAY) {
-    m_lastTime = millis();
-    m_state = (m_state == kModifierStateOff) ? kModifierStateLatched
-                                             : kModifierStateOff;
-  }
-}
+#define OFF kModifierStateOff
+#define LATCHED kModifierStateLatched
+#define LOCKED kModifierStateLocked
 
-void IKModifier::UpdateState(uint8_t mask) {
-  // skip if it is changed in the last 5ms
-  if (millis() - m_lastTime > IK_MODIFIER_CHANGE_DELAY) {
-    m_lastTime = millis();
+// next state [action][event][state]
+static uint8_t const modifierTransition[3][IK_MOD_EVENT_COUNT][3] = {
+    [kSettingsShiftLatching] =
+        {
+            [IK_MOD_EVENT_PRESS] = {LATCHED, OFF, OFF},
+            [IK_MOD_EVENT_KEY] = {OFF, OFF, LOCKED},
+            [IK_MOD_EVENT_CLEAR] = {OFF, OFF, OFF},
+        },
+    [kSettingsShiftLocking] =
+        {
+            [IK_MOD_EVENT_PRESS] = {LATCHED, LOCKED, OFF},
+            [IK_MOD_EVENT_KEY] = {OFF, OFF, LOCKED},
+            [IK_MOD_EVENT_CLEAR] = {OFF, OFF, OFF},
+        },
+    [kSettingsShiftNoLatch] =
+        {
+            // modifier is only down while its key is held
+            [IK_MOD_EVENT_PRESS] = {OFF, OFF, OFF},
+            [IK_MOD_EVENT_KEY] = {OFF, OFF, OFF},
+            [IK_MOD_EVENT_CLEAR] = {OFF, OFF, OFF},
+        },
+};
 
-    if (mask & m_mask) {
-      // toggle if it is our mask
-      m_state = (m_state == kModifierStateOff) ? kModifierStateLatched
-                                               : kModifierStateOff;
+void IKModifiers::update(uint8_t mods, uint8_t event, uint8_t action,
+                         uint32_t now) {
+  if (event == IK_MOD_EVENT_PRESS) {
+    if (now - _lastTime <= IK_MODIFIER_CHANGE_DELAY) {
+      return;
     }
+    _lastTime = now;
   }
-}
-
-void IKModifier::SetState(int state) { m_state = state; }
 
-void IKModifier::Execute(int code) {
-  int theCode = m_universalCode;
-  m_universalCodeOverride = 0;
-  if (code != 0) {
-    theCode = code;
-    m_universalCodeOverride = theCode;
+  if (action > kSettingsShiftNoLatch) {
+    action = kSettingsShiftLatching;
   }
+  uint8_t const(*next)[3] = modifierTransition[action];
 
-  IKSettings *pSettings = IKSettings::GetSettings();
-  if (pSettings == NULL)
-    return;
-
-  switch (pSettings->m_iShiftKeyAction) {
-  case kSettingsShiftLatching:
-    if (m_state == kModifierStateOff) {
-      //  was off, turn on and put down
-      m_device->PostKey(theCode, IK_DOWN);
-      m_state = kModifierStateLatched;
-    } else {
-      //  was on, put up and turn off
-      m_device->PostKey(theCode, IK_UP);
-      m_state = kModifierStateOff;
+  uint32_t word = _word & 0xffff;
+  for (uint8_t mod = 0; mod < IK_MOD_COUNT; mod++) {
+    if (mods & (1u << mod)) {
+      uint8_t const shift = mod * 2;
+      uint8_t const state = (word >> shift) & 0x03;
+      word = (word & ~(0x03ul << shift)) |
+             ((uint32_t)next[event][state] << shift);
     }
-    break;
-
-  case kSettingsShiftLocking:
-    if (m_state == kModifierStateOff) {
-      //  put key down, state = latched
-      m_device->PostKey(theCode, IK_DOWN);
-      m_state = kModifierStateLatched;
-    } else if (m_state == kModifierStateLatched) {
-      //  leave key alone, state = locked
-      m_state = kModifierStateLocked;
-    } else if (m_state == kModifierStateLocked) {
-      //  put key up, state = off
-      m_device->PostKey(theCode, IK_UP);
-      m_state = kModifierStateOff;
-    }
-    break;
+  }
 
-  case kSettingsShiftNoLatch:
-    //  just put the key down/up, no change in state
-    {
-      int keyDownDelay = 5;
-      m_device->PostKey(theCode, IK_DOWN, keyDownDelay);
-      // m_device->PostKey(theCode,IK_UP,keyDownDelay);
-      m_state = kModifierStateLatched;
+  uint8_t hid = 0;
+  for (uint8_t mod = 0; mod < IK_MOD_MOUSE_DOWN; mod++) {
+    if ((word >> (mod * 2)) & 0x03) {
+      hid |= (uint8_t)(1u << mod);
     }
-    break;
-
-  default:
-    break;
   }
+
+  // single store, report builder on the other core sees old or new state
+  _word = word | ((uint32_t)hid << 16);
 }
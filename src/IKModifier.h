@@ -26,34 +26,56 @@ enum {
 
 enum { kModifierStateOff = 0, kModifierStateLatched, kModifierStateLocked };
 
-class Adafruit_IntelliKeys;
+// Latchable modifiers, order of the first 4 follows HID modifier bits so that
+// a set of modifiers is also their (left) HID modifier mask
+enum {
+  IK_MOD_CONTROL = 0,
+  IK_MOD_SHIFT,
+  IK_MOD_ALT,
+  IK_MOD_COMMAND,
+  IK_MOD_MOUSE_DOWN, // click hold
+  IK_MOD_COUNT
+};
 
-class IKModifier {
+#define IK_MOD_KEYBOARD_MASK 0x0f
 
+// Modifier events
+enum {
+  IK_MOD_EVENT_PRESS = 0, // modifier key pressed
+  IK_MOD_EVENT_KEY,       // a non-modifier key is typed
+  IK_MOD_EVENT_CLEAR,     // lift all
+  IK_MOD_EVENT_COUNT
+};
+
+// State of all latchable modifiers packed in a single word: 2 bits state per
+// modifier, and the HID modifier mask of latched/locked keyboard modifiers
+// kept alongside so that the report only ORs it. Transitions follow the
+// IKSettings m_iShiftKeyAction (latching, locking or no latch) from a table
+// indexed by (action, event, state).
+class IKModifiers {
 public:
-  IKModifier(uint8_t mask = 0) {
-    m_state = kModifierStateOff;
-    m_lastTime = 0;
-    m_mask = mask;
+  IKModifiers() { clear(); }
+
+  void clear(void) {
+    _word = 0;
+    _lastTime = 0;
   }
-  virtual ~IKModifier() {}
-  void Execute(int code = 0);
-  uint8_t GetState() { return m_state; }
-  void SetState(int state);
-  void SetCode(uint8_t code) { m_universalCode = code; }
 
-  void ToggleState();
-  void UpdateState(uint8_t mask);
+  // Apply event to a set of modifiers (bit per IK_MOD_*). Presses within
+  // IK_MODIFIER_CHANGE_DELAY of the previous one are ignored.
+  void update(uint8_t mods, uint8_t event, uint8_t action, uint32_t now);
 
-  uint8_t m_state;
-  uint8_t m_mask;
+  uint8_t getState(uint8_t mod) { return (_word >> (mod * 2)) & 0x03; }
+  uint8_t getHidModifier(void) { return (uint8_t)(_word >> 16); }
 
-  int m_universalCode;
-  int m_universalCodeOverride;
-  uint32_t m_lastTime;
+  // HID modifier mask (left or right) to set of modifiers
+  static uint8_t fromHid(uint8_t hid_modifier) {
+    return (hid_modifier | (hid_modifier >> 4)) & IK_MOD_KEYBOARD_MASK;
+  }
 
-  void SetDevice(Adafruit_IntelliKeys *pDev) { m_device = pDev; }
-  Adafruit_IntelliKeys *m_device;
+private:
+  volatile uint32_t _word; // bit 0-9: states, bit 16-23: HID modifier mask
+  uint32_t _lastTime;
 };
 
 #endif // ADAFRUIT_INTELLIKEYS_IKMODIFIER_H
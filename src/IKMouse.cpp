@@ -0,0 +1,188 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "IKMouse.h"
+#include "IKSettings.h"
+
+IKMouse::IKMouse() {
+  _interval = IK_MOUSE_INTERVAL;
+  _dirInput = 0;
+  _addX = _addY = 0;
+  _resetCount = 0;
+  _inputX = _inputY = 0;
+
+  _dirX = _dirY = 0;
+  _holdTime = _lastTime = _lastOutput = 0;
+  _resetTaken = 0;
+  _takenX = _takenY = 0;
+  _accX = _accY = 0;
+}
+
+// Motion not yet output is dropped by getMotion()
+void IKMouse::reset(void) {
+  _inputX = _inputY = 0;
+  _dirInput = 0;
+  _resetCount = _resetCount + 1;
+}
+
+// Speed in pixels per second after direction is held for held_ms
+uint32_t IKMouse::speed(uint32_t held_ms) {
+  int rate = IKSettings::GetSettings()->m_iMouseSpeed;
+  if (rate < kSettingsRateLow) {
+    rate = kSettingsRateLow;
+  } else if (rate > kSettingsRateHigh) {
+    rate = kSettingsRateHigh;
+  }
+
+  uint32_t const max_speed = IK_MOUSE_MAX_SPEED * rate / kSettingsRateHigh;
+  if (max_speed <= IK_MOUSE_START_SPEED) {
+    return IK_MOUSE_START_SPEED;
+  }
+
+  if (held_ms >= IK_MOUSE_ACCEL_TIME) {
+    return max_speed;
+  }
+
+  // quadratic curve: slow start for fine control, then ramp up quickly
+  uint32_t const t = (held_ms << 8) / IK_MOUSE_ACCEL_TIME; // 0-255
+  return IK_MOUSE_START_SPEED +
+         ((max_speed - IK_MOUSE_START_SPEED) * t * t >> 16);
+}
+
+// Accumulate motion of held direction up to now
+void IKMouse::advance(uint32_t now) {
+  if (isMoving()) {
+    uint32_t dt = now - _lastTime;
+
+    // limit step in case we are not polled for a long time
+    if (dt > 100) {
+      dt = 100;
+    }
+
+    if (dt) {
+      // average speed over the interval, pixels/s * ms * 256 / 1000
+      uint32_t const v =
+          (speed(_lastTime - _holdTime) + speed(now - _holdTime)) / 2;
+      int32_t const d = (int32_t)(v * dt * 256 / 1000);
+      _accX += _dirX * d;
+      _accY += _dirY * d;
+    }
+  }
+  _lastTime = now;
+}
+
+void IKMouse::setDirection(int8_t dx, int8_t dy) {
+  if (dx == _inputX && dy == _inputY) {
+    return;
+  }
+
+  if ((dx || dy) && !_inputX && !_inputY) {
+    // newly pressed: move 1 pixel right away so that a short tap still
+    // gives the finest step, even when released before next getMotion()
+    addMotion(dx * 256, dy * 256);
+  }
+
+  _inputX = dx;
+  _inputY = dy;
+  _dirInput = (uint16_t)((uint8_t)dx | ((uint8_t)dy << 8));
+}
+
+// Running totals, only the difference since last time is used
+void IKMouse::addMotion(int32_t dx, int32_t dy) {
+  _addX = (int32_t)((uint32_t)_addX + (uint32_t)dx);
+  _addY = (int32_t)((uint32_t)_addY + (uint32_t)dy);
+}
+
+void IKMouse::updateDirection(uint32_t now) {
+  uint16_t const dir = _dirInput;
+  int8_t const dx = (int8_t)(dir & 0xff);
+  int8_t const dy = (int8_t)(dir >> 8);
+
+  if (dx == _dirX && dy == _dirY) {
+    return;
+  }
+
+  advance(now);
+
+  if (dx || dy) {
+    if (!isMoving()) {
+      _holdTime = now;
+    }
+  } else {
+    // released: drop pixel fraction so that next press starts clean
+    _accX -= _accX % 256;
+    _accY -= _accY % 256;
+  }
+
+  _dirX = dx;
+  _dirY = dy;
+}
+
+static inline int8_t takePixels(int32_t *acc) {
+  int32_t px = *acc / 256;
+  if (px > 127) {
+    px = 127;
+  } else if (px < -127) {
+    px = -127;
+  }
+  *acc -= px * 256;
+  return (int8_t)px;
+}
+
+bool IKMouse::getMotion(uint32_t now, int8_t *x, int8_t *y) {
+  *x = *y = 0;
+
+  if (now - _lastOutput < _interval) {
+    return false;
+  }
+
+  uint32_t const reset_count = _resetCount;
+  if (reset_count != _resetTaken) {
+    _resetTaken = reset_count;
+    _dirX = _dirY = 0;
+    _accX = _accY = 0;
+    _takenX = _addX;
+    _takenY = _addY;
+  }
+
+  updateDirection(now);
+  advance(now);
+
+  int32_t const add_x = _addX;
+  int32_t const add_y = _addY;
+  _accX += (int32_t)((uint32_t)add_x - (uint32_t)_takenX);
+  _accY += (int32_t)((uint32_t)add_y - (uint32_t)_takenY);
+  _takenX = add_x;
+  _takenY = add_y;
+
+  *x = takePixels(&_accX);
+  *y = takePixels(&_accY);
+
+  if (*x == 0 && *y == 0) {
+    return false;
+  }
+
+  _lastOutput = now;
+  return true;
+}
@@ -0,0 +1,100 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKMOUSE_H
+#define ADAFRUIT_INTELLIKEYS_IKMOUSE_H
+
+#include <stdint.h>
+
+// Pointer speed (pixels per second) when a mouse key is first pressed
+#define IK_MOUSE_START_SPEED 60
+
+// Pointer speed (pixels per second) after acceleration with the highest
+// Mouse Speed setting. Lower settings scale it down linearly.
+#define IK_MOUSE_MAX_SPEED 4000
+
+// Time (ms) to accelerate from start to max speed
+#define IK_MOUSE_ACCEL_TIME 500
+
+// Default minimum interval (ms) between 2 motion outputs
+#define IK_MOUSE_INTERVAL 1
+
+// Time based mouse motion engine. Motion is computed from elapsed time, not
+// from the number of calls, so pointer speed does not depend on the poll
+// period. Speed follows a quadratic acceleration curve while a direction is
+// held, fractional pixels are kept in 1/256 pixel accumulators.
+//
+// reset(), setDirection() and addMotion() are called by the core processing
+// IntelliKeys input while getMotion() is called by the core sending reports.
+// Input only writes the volatile words below, each by a single writer, all
+// motion state is owned by getMotion().
+class IKMouse {
+public:
+  IKMouse();
+
+  void reset(void);
+
+  // Direction (-1, 0, 1 for each axis) of the mouse keys currently held
+  void setDirection(int8_t dx, int8_t dy);
+
+  // Add relative motion in 1/256 pixel e.g from trackpad
+  void addMotion(int32_t dx, int32_t dy);
+
+  // Minimum interval in ms between motion outputs
+  void setInterval(uint8_t ms) { _interval = ms; }
+
+  // Get whole pixel motion since last output, fraction is kept for next
+  // time. Return false if interval is not elapsed or there is no motion.
+  bool getMotion(uint32_t now, int8_t *x, int8_t *y);
+
+private:
+  // written by input
+  volatile uint16_t _dirInput; // x in low byte, y in high byte
+  volatile int32_t _addX;      // running total of added motion, 1/256 pixel
+  volatile int32_t _addY;
+  volatile uint32_t _resetCount;
+  int8_t _inputX; // last direction set, to detect new press
+  int8_t _inputY;
+
+  // owned by getMotion()
+  int8_t _dirX;
+  int8_t _dirY;
+  uint32_t _holdTime; // time when direction is pressed
+  uint32_t _lastTime; // time of last motion computation
+  uint32_t _lastOutput;
+  uint8_t _interval;
+  uint32_t _resetTaken;
+  int32_t _takenX; // _addX already accumulated
+  int32_t _takenY;
+
+  int32_t _accX; // 1/256 pixel
+  int32_t _accY;
+
+  bool isMoving(void) { return _dirX || _dirY; }
+  void advance(uint32_t now);
+  void updateDirection(uint32_t now);
+  uint32_t speed(uint32_t held_ms);
+};
+
+#endif // ADAFRUIT_INTELLIKEYS_IKMOUSE_H
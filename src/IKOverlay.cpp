@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  */
 
+#include "IKKeycode.h"
+#include "IKMacro.h"
 #include "IKOverlay.h"
 #include "class/hid/hid.h"
 
@@ -36,18 +38,81 @@
 
 IKOverlay stdOverlays[7];
 
-IKOverlay::IKOverlay() { memset(_membrane, 0, sizeof(_membrane)); }
+IKOverlay::IKOverlay() { clear(); }
+
+void IKOverlay::clear(void) {
+  memset(_key_id, 0, sizeof(_key_id));
+  memset(_keys, 0, sizeof(_keys));
+  _key_count = 1; // key 0 is empty
+  memset(_switches, 0, sizeof(_switches));
+  memset(&_trackpad, 0, sizeof(_trackpad));
+}
+
+void IKOverlay::setSwitchReport(int nswitch, ik_report_t const *report) {
+  if (nswitch < 0 || nswitch >= IK_NUM_SWITCHES) {
+    return;
+  }
+  _switches[nswitch] = *report;
+}
 
 void IKOverlay::getSwitchReport(int nswitch, ik_report_t *report) {
-  (void)nswitch;
-  (void)report;
+  if (nswitch < 0 || nswitch >= IK_NUM_SWITCHES) {
+    return;
+  }
+  *report = _switches[nswitch];
 }
 
 void IKOverlay::getMembraneReport(int row, int col, ik_report_t *report) {
-  if (row > IK_RESOLUTION_X || col > IK_RESOLUTION_Y) {
+  if (row >= IK_RESOLUTION_X || col >= IK_RESOLUTION_Y) {
     return;
   }
-  *report = _membrane[row][col];
+  *report = _keys[_key_id[row][col]];
+}
+
+// Size of the union member used by report type, other bytes of the union may
+// be uninitialized
+static uint8_t reportDataSize(uint8_t type) {
+  switch (type) {
+  case IK_REPORT_TYPE_KEYBOARD:
+    return sizeof(ik_report_keyboard_t);
+  case IK_REPORT_TYPE_MOUSE:
+    return sizeof(ik_report_mouse_t);
+  case IK_REPORT_TYPE_MACRO:
+    return sizeof(ik_report_macro_t);
+  case IK_REPORT_TYPE_UNICODE:
+    return sizeof(ik_report_unicode_t);
+  case IK_REPORT_TYPE_PREDICT:
+    return sizeof(ik_report_predict_t);
+  default:
+    return 0;
+  }
+}
+
+// Find key ID of the report, add new key if not found. Only the active fields
+// are compared and stored, unused bytes of a stored key are zero.
+uint8_t IKOverlay::addKey(ik_report_t const *report) {
+  if (report->type == IK_REPORT_TYPE_NONE) {
+    return 0;
+  }
+
+  ik_report_t key;
+  memset(&key, 0, sizeof(key));
+  key.type = report->type;
+  memcpy(&key.keyboard, &report->keyboard, reportDataSize(report->type));
+
+  for (uint8_t id = 1; id < _key_count; id++) {
+    if (0 == memcmp(&_keys[id], &key, sizeof(ik_report_t))) {
+      return id;
+    }
+  }
+
+  if (_key_count >= IK_OVERLAY_MAX_KEYS) {
+    IK_PRINTF("Too many keys, please increase IK_OVERLAY_MAX_KEYS\r\n");
+    return 0;
+  }
+
+  _keys[_key_count] = key;
+  return _key_count++;
 }
 
 void IKOverlay::setMembraneReport(int top_row, int top_col, int height,
@@ -65,10 +130,12 @@ void IKOverlay::setMembraneReport(int top_row, int top_col, int height,
     return;
   }
 
+  uint8_t const key_id = addKey(report);
+
   for (int row = top_row; row < top_row + height; row++) {
     for (int col = top_col; col < top_col + width; col++) {
-      _membrane[row][col] = *report;
-      IK_PRINTF("_membrane[%u][%u] = %u\r\n", row, col, _membrane[row][col]);
+      _key_id[row][col] = key_id;
+      IK_PRINTF("_key_id[%u][%u] = %u\r\n", row, col, key_id);
     }
   }
 }
@@ -82,6 +149,16 @@ void IKOverlay::initStandardOverlays(void) {
   initStdBasicWriting();
 }
 
+void IKOverlay::setStdMouseAccessTrackpad(bool enable) {
+  IKOverlay &overlay = stdOverlays[IK_OVERLAY_MOUSE_ACCESS];
+  overlay.clear();
+  initStdMouseAccess();
+
+  if (enable) {
+    overlay.setMembraneTrackpad(6, 6, 18, 12);
+  }
+}
+
 //--------------------------------------------------------------------+
 // Web Access
 //--------------------------------------------------------------------+
@@ -124,18 +201,23 @@ void IKOverlay::initStdWebAccess(void) {
       {0, HID_KEY_GRAVE},
       {0, 0},                                  // empty
       {KEYBOARD_MODIFIER_LEFTCTRL, HID_KEY_L}, // goto address bar
-                                               // www.
-                                               // .com
-                                               // .net
-                                               // .gov
-                                               // .edu
-                                               // .org
-                                               // IntelliTools ?
   };
 
   overlay.setMembraneKeyboardArr(row, col, height, width, second_row,
                                  sizeof(second_row) / sizeof(second_row[0]));
 
+  col += width * (sizeof(second_row) / sizeof(second_row[0]));
+
+  uint8_t const second_row_macros[] = {
+      IK_MACRO_WWW, IK_MACRO_COM, IK_MACRO_NET,
+      IK_MACRO_GOV, IK_MACRO_EDU, IK_MACRO_ORG,
+      // IntelliTools ?
+  };
+
+  overlay.setMembraneMacroArr(
+      row, col, height, width, second_row_macros,
+      sizeof(second_row_macros) / sizeof(second_row_macros[0]));
+
   // Row 3 to 8
   initStdQwertyRow3to8(overlay, true);
 }
@@ -546,7 +628,7 @@ void IKOverlay::initStdQwerty(void) {
       {0, HID_KEY_INSERT},
       {0, HID_KEY_HOME},
       {0, HID_KEY_END},
-      {0, 0}, // TODO smart typing
+      {0, 0}, // smart typing, set below
       {0, HID_KEY_PAGE_UP},
       {0, HID_KEY_PAGE_DOWN},
       {0, HID_KEY_DELETE},
@@ -555,6 +637,10 @@ void IKOverlay::initStdQwerty(void) {
   overlay.setMembraneKeyboardArr(row, col, height, width, first_row,
                                  sizeof(first_row) / sizeof(first_row[0]));
 
+  report.type = IK_REPORT_TYPE_SMART_TYPING;
+  overlay.setMembraneReport(row, 9 * width, height, width, &report);
+  report.type = IK_REPORT_TYPE_KEYBOARD;
+
   //------------- Second Row -------------//
   row = 3;
   col = 0;
@@ -832,6 +918,65 @@ void IKOverlay::setMembraneKeyboardArr(int row, int col, int height, int width,
   }
 }
 
+// Row of keys given in universal codes (OpenIKeys overlays), code that is not
+// a key leaves its cells empty
+void IKOverlay::setMembraneUniversalArr(int row, int col, int height,
+                                        int width, uint8_t const codes[],
+                                        uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    ik_report_t report;
+    report.type = IK_REPORT_TYPE_NONE;
+    if (ik_universal_to_keyboard(codes[i], &report.keyboard)) {
+      report.type = IK_REPORT_TYPE_KEYBOARD;
+    }
+
+    setMembraneReport(row, col, height, width, &report);
+    col += width;
+  }
+}
+
+// Row of macro keys, each types macro number macros[i] of the macro pool
+void IKOverlay::setMembraneMacroArr(int row, int col, int height, int width,
+                                    uint8_t const macros[], uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    ik_report_t report;
+    memset(&report, 0, sizeof(report));
+    report.type = IK_REPORT_TYPE_MACRO;
+    report.macro.index = macros[i];
+
+    setMembraneReport(row, col, height, width, &report);
+    col += width;
+  }
+}
+
+// Row of non-ASCII character keys, typed with the host input method
+void IKOverlay::setMembraneUnicodeArr(int row, int col, int height, int width,
+                                      uint16_t const code_points[],
+                                      uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    ik_report_t report;
+    report.type = IK_REPORT_TYPE_UNICODE;
+    report.unicode.code_point = code_points[i];
+
+    setMembraneReport(row, col, height, width, &report);
+    col += width;
+  }
+}
+
+// Row of word prediction keys, each types completion number indexes[i]
+void IKOverlay::setMembranePredictArr(int row, int col, int height, int width,
+                                      uint8_t const indexes[], uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    ik_report_t report;
+    memset(&report, 0, sizeof(report));
+    report.type = IK_REPORT_TYPE_PREDICT;
+    report.predict.index = indexes[i];
+
+    setMembraneReport(row, col, height, width, &report);
+    col += width;
+  }
+}
+
 void IKOverlay::setMembraneMouseArr(int row, int col, int height, int width,
                                     ik_report_mouse_t const mouse_report[],
                                     uint8_t count) {
@@ -845,6 +990,20 @@ void IKOverlay::setMembraneMouseArr(int row, int col, int height, int width,
   }
 }
 
+void IKOverlay::setMembraneTrackpad(int row, int col, int height, int width) {
+  ik_report_t report;
+  report.type = IK_REPORT_TYPE_MOUSE;
+  report.mouse.buttons = IK_REPORT_MOUSE_TRACKPAD;
+  report.mouse.x = report.mouse.y = 0;
+
+  setMembraneReport(row, col, height, width, &report);
+
+  _trackpad.row = row;
+  _trackpad.col = col;
+  _trackpad.height = height;
+  _trackpad.width = width;
+}
+
 void IKOverlay::initQwertyRow(int row, int col, int height, int width) {
   ik_report_keyboard_t kbd_item[] = {
       {0, HID_KEY_Q}, {0, HID_KEY_W}, {0, HID_KEY_E}, {0, HID_KEY_R},
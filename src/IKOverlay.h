@@ -46,11 +46,30 @@ Standard_Overlay_7_Name		none
 #define IK_OVERLAY_QWERTY 5
 #define IK_OVERLAY_BASIC_WRITING 6
 
-enum { IK_REPORT_TYPE_NONE = 0, IK_REPORT_TYPE_KEYBOARD, IK_REPORT_TYPE_MOUSE };
+// Maximum number of distinct keys per overlay. Key ID 0 is reserved for
+// empty cell (no report)
+#define IK_OVERLAY_MAX_KEYS 250
+
+// Switch inputs are keys too, with ID following overlay keys so that all key
+// IDs fit in a byte
+#define IK_SWITCH_KEY_ID(n) (IK_OVERLAY_MAX_KEYS + (n))
+#define IK_KEY_ID_COUNT (IK_OVERLAY_MAX_KEYS + IK_NUM_SWITCHES)
+
+enum {
+  IK_REPORT_TYPE_NONE = 0,
+  IK_REPORT_TYPE_KEYBOARD,
+  IK_REPORT_TYPE_MOUSE,
+  IK_REPORT_TYPE_MACRO,   // types a string or key sequence, see IKMacro
+  IK_REPORT_TYPE_UNICODE, // types a character with host input method
+  IK_REPORT_TYPE_SMART_TYPING, // toggles smart typing, see IKSmartTyping
+  IK_REPORT_TYPE_PREDICT,      // types a word completion, see IKPredict
+};
 
 enum {
+  IK_REPORT_MOUSE_BUTTON_MASK = 0x1f, // bit 0-4 are HID mouse buttons
   IK_REPORT_MOUSE_DOUBLE_CLICK = (1u << 5),
   IK_REPORT_MOUSE_CLICK_HOLD = (1u << 6),
+  IK_REPORT_MOUSE_TRACKPAD = (1u << 7), // cell is part of trackpad region
 };
 
 typedef struct __attribute__((packed)) {
@@ -65,13 +84,35 @@ typedef struct __attribute__((packed)) {
 } ik_report_mouse_t;
 
 typedef struct __attribute__((packed)) {
-  uint8_t type; // 0: for none, 1 for keyboard, 2 for mouse
+  uint8_t index; // macro pool index
+  uint8_t reserved;
+} ik_report_macro_t;
+
+typedef struct __attribute__((packed)) {
+  uint16_t code_point; // Basic Multilingual Plane
+} ik_report_unicode_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t index; // completion index, most likely first
+  uint8_t reserved;
+} ik_report_predict_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t type; // IK_REPORT_TYPE_*
   union {
     ik_report_keyboard_t keyboard;
     ik_report_mouse_t mouse;
+    ik_report_macro_t macro;
+    ik_report_unicode_t unicode;
+    ik_report_predict_t predict;
   };
 } ik_report_t;
 
+// Switch overlay: action of each switch input, selectable at runtime
+typedef struct {
+  ik_report_t switches[IK_NUM_SWITCHES];
+} ik_switch_overlay_t;
+
 class IKOverlay {
 public:
   IKOverlay();
@@ -79,21 +120,73 @@ public:
   // Init all std overlays
   static void initStandardOverlays(void);
 
+  // Use the direction keys (and the click key between them) of the std Mouse
+  // Access overlay as a trackpad, click keys on the sides are kept. The
+  // overlay is rebuilt in place, call it only from the core using it.
+  static void setStdMouseAccessTrackpad(bool enable);
+
   void setMembraneReport(int top_row, int top_col, int height, int width,
                          ik_report_t *report);
 
+  // Overlay can also define switch actions (nswitch is 0-based), these take
+  // precedence over the selected switch overlay
+  void setSwitchReport(int nswitch, ik_report_t const *report);
   void getSwitchReport(int nswitch, ik_report_t *report);
+  ik_report_t const *getSwitchKeyReport(uint8_t nswitch) {
+    return &_switches[nswitch];
+  }
   void getMembraneReport(int row, int col, ik_report_t *report);
 
+  // Each distinct report is assigned a small key ID when it is set to the
+  // membrane, so that all cells of a multi-cell key share the same ID.
+  uint8_t getKeyId(int row, int col) { return _key_id[row][col]; }
+  ik_report_t const *getKeyReport(uint8_t key_id) { return &_keys[key_id]; }
+  uint8_t getKeyCount(void) { return _key_count; }
+
   void setMembraneKeyboardArr(int row, int col, int height, int width,
                               const ik_report_keyboard_t kbd_report[],
                               uint8_t count);
   void setMembraneMouseArr(int row, int col, int height, int width,
                            ik_report_mouse_t const mouse_report[],
                            uint8_t count);
+  void setMembraneUniversalArr(int row, int col, int height, int width,
+                               uint8_t const codes[], uint8_t count);
+  void setMembraneMacroArr(int row, int col, int height, int width,
+                           uint8_t const macros[], uint8_t count);
+  void setMembraneUnicodeArr(int row, int col, int height, int width,
+                             uint16_t const code_points[], uint8_t count);
+  void setMembranePredictArr(int row, int col, int height, int width,
+                             uint8_t const indexes[], uint8_t count);
+
+  // Use a membrane region as trackpad, touch motion within it moves pointer
+  void setMembraneTrackpad(int row, int col, int height, int width);
+  bool hasTrackpad(void) { return _trackpad.height != 0; }
+  void getTrackpad(uint8_t *row, uint8_t *col, uint8_t *height,
+                   uint8_t *width) {
+    *row = _trackpad.row;
+    *col = _trackpad.col;
+    *height = _trackpad.height;
+    *width = _trackpad.width;
+  }
+  bool isTrackpadKey(uint8_t key_id) {
+    return (_keys[key_id].type == IK_REPORT_TYPE_MOUSE) &&
+           (_keys[key_id].mouse.buttons & IK_REPORT_MOUSE_TRACKPAD);
+  }
 
 private:
-  ik_report_t _membrane[IK_RESOLUTION_X][IK_RESOLUTION_Y];
+  // cell -> key ID, key ID -> report
+  uint8_t _key_id[IK_RESOLUTION_X][IK_RESOLUTION_Y];
+  ik_report_t _keys[IK_OVERLAY_MAX_KEYS];
+  uint8_t _key_count;
+
+  ik_report_t _switches[IK_NUM_SWITCHES];
+
+  struct {
+    uint8_t row, col, height, width;
+  } _trackpad;
+
+  uint8_t addKey(ik_report_t const *report);
+  void clear(void);
 
   // init each std overlays
   static void initStdWebAccess(void);
@@ -0,0 +1,387 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "IKPredict.h"
+#include "class/hid/hid.h"
+
+// Dictionary layout, see tools/ik_dict.py
+#define DICT_HEADER_SIZE 12
+#define DICT_NODE_WORD_END 0x80
+#define DICT_NODE_CHILD_MASK 0x3f
+
+IKPredict::IKPredict() {
+  _dict = NULL;
+  _size = 0;
+  _count = 0;
+  _frontier_count = 0;
+  _lookup_count = 0;
+  _visit_max = 0;
+  clear();
+}
+
+bool IKPredict::setDictionary(uint8_t const *dict) {
+  _dict = NULL;
+  _size = 0;
+  _dirty = true;
+
+  if (dict == NULL || 0 != memcmp(dict, "IKD1", 4) ||
+      dict[10] > IK_PREDICT_WORD_MAX) {
+    return false;
+  }
+
+  uint32_t const size = dict[4] | (dict[5] << 8) | ((uint32_t)dict[6] << 16) |
+                        ((uint32_t)dict[7] << 24);
+  if (size <= DICT_HEADER_SIZE) {
+    return false;
+  }
+
+  _dict = dict;
+  _size = size;
+  return true;
+}
+
+uint16_t IKPredict::getWordCount(void) {
+  return _dict ? (uint16_t)(_dict[8] | (_dict[9] << 8)) : 0;
+}
+
+void IKPredict::clear(void) {
+  _len = 0;
+  _prefix[0] = 0;
+  _valid = true;
+  _dirty = true;
+}
+
+static bool isSeparator(uint8_t keycode) {
+  switch (keycode) {
+  case HID_KEY_SPACE:
+  case HID_KEY_ENTER:
+  case HID_KEY_KEYPAD_ENTER:
+  case HID_KEY_TAB:
+    return true;
+  default:
+    break;
+  }
+
+  // digits and punctuation - = [ ] \ # ; ' ` , . /
+  return (keycode >= HID_KEY_1 && keycode <= HID_KEY_0) ||
+         (keycode >= HID_KEY_MINUS && keycode <= HID_KEY_SLASH);
+}
+
+void IKPredict::record(uint8_t keycode, bool shifted) {
+  char ch = 0;
+  if (keycode >= HID_KEY_A && keycode <= HID_KEY_Z) {
+    ch = (char)('a' + keycode - HID_KEY_A);
+  } else if (keycode == HID_KEY_APOSTROPHE && !shifted) {
+    ch = '\'';
+  }
+
+  if (ch) {
+    if (_valid && _len < IK_PREDICT_WORD_MAX) {
+      _prefix[_len++] = ch;
+    } else {
+      _valid = false; // too long for any word
+    }
+  } else if (keycode == HID_KEY_BACKSPACE) {
+    if (_len) {
+      _len--;
+    } else {
+      _valid = false; // back into previous word
+    }
+  } else if (keycode >= HID_KEY_CONTROL_LEFT &&
+             keycode <= HID_KEY_GUI_RIGHT) {
+    return; // modifiers are not text
+  } else if (isSeparator(keycode)) {
+    _len = 0;
+    _valid = true;
+  } else {
+    _valid = false; // unknown text or cursor moved
+  }
+
+  _prefix[_len] = 0;
+  _dirty = true;
+}
+
+char const *IKPredict::getPrefix(void) { return _valid ? _prefix : NULL; }
+
+uint8_t IKPredict::getCount(void) {
+  if (_dirty) {
+    _count = _valid ? lookup(_prefix) : 0;
+    _dirty = false;
+  }
+  return _count;
+}
+
+char const *IKPredict::getWord(uint8_t index) {
+  return (index < getCount()) ? _words[index] : NULL;
+}
+
+// Completions start with the prefix
+char const *IKPredict::getCompletion(uint8_t index) {
+  char const *word = getWord(index);
+  return word ? word + _len : NULL;
+}
+
+//--------------------------------------------------------------------+
+// Dictionary access, every read is bound checked
+//--------------------------------------------------------------------+
+
+bool IKPredict::readNode(uint32_t offset, node_t *node) {
+  if (offset < DICT_HEADER_SIZE || offset >= _size) {
+    return false;
+  }
+
+  uint32_t pos = offset;
+  uint8_t const flags = _dict[pos++];
+  node->offset = offset;
+  node->count = flags & DICT_NODE_CHILD_MASK;
+  node->freq = 0;
+
+  if (flags & DICT_NODE_WORD_END) {
+    if (pos >= _size) {
+      return false;
+    }
+    node->freq = _dict[pos++];
+  }
+
+  node->best = node->freq;
+  if (node->count) {
+    if (pos >= _size) {
+      return false;
+    }
+    node->best = _dict[pos++];
+  }
+
+  node->edges = pos;
+  return true;
+}
+
+// Read edge at pos and advance pos. First child directly follows the node
+// (at end), others are given as varint offset from the node.
+bool IKPredict::readEdge(node_t const *node, uint32_t *pos, bool first,
+                         uint32_t end, edge_t *edge) {
+  uint32_t p = *pos;
+  if (p >= _size) {
+    return false;
+  }
+
+  edge->len = _dict[p++];
+  edge->label = p;
+  if (edge->len == 0 || edge->len > IK_PREDICT_WORD_MAX ||
+      p + edge->len > _size) {
+    return false;
+  }
+  p += edge->len;
+
+  if (first) {
+    edge->child = end;
+  } else {
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    while (1) {
+      if (p >= _size || shift > 21) {
+        return false;
+      }
+      uint8_t const b = _dict[p++];
+      value |= (uint32_t)(b & 0x7f) << shift;
+      if (!(b & 0x80)) {
+        break;
+      }
+      shift += 7;
+    }
+    edge->child = node->offset + value;
+  }
+
+  *pos = p;
+  return true;
+}
+
+bool IKPredict::nodeEnd(node_t const *node, uint32_t *end) {
+  uint32_t pos = node->edges;
+  edge_t edge;
+  for (uint8_t i = 0; i < node->count; i++) {
+    if (!readEdge(node, &pos, i == 0, 0, &edge)) {
+      return false;
+    }
+  }
+  *end = pos;
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Lookup
+//--------------------------------------------------------------------+
+
+// Add to frontier, when full the least likely entry is dropped
+void IKPredict::push(entry_t const *entry) {
+  if (_frontier_count < IK_PREDICT_FRONTIER) {
+    _frontier[_frontier_count++] = *entry;
+    return;
+  }
+
+  uint8_t low = 0;
+  for (uint8_t i = 1; i < IK_PREDICT_FRONTIER; i++) {
+    if (_frontier[i].priority < _frontier[low].priority) {
+      low = i;
+    }
+  }
+
+  if (entry->priority > _frontier[low].priority) {
+    _frontier[low] = *entry;
+  }
+}
+
+bool IKPredict::pushChildren(entry_t const *parent, node_t const *node) {
+  uint32_t end;
+  if (!nodeEnd(node, &end)) {
+    return false;
+  }
+
+  uint32_t pos = node->edges;
+  for (uint8_t i = 0; i < node->count; i++) {
+    edge_t edge;
+    node_t child;
+    if (!readEdge(node, &pos, i == 0, end, &edge) ||
+        !readNode(edge.child, &child)) {
+      return false;
+    }
+
+    if (parent->len + edge.len > IK_PREDICT_WORD_MAX) {
+      continue;
+    }
+
+    entry_t entry;
+    entry.offset = edge.child;
+    entry.priority = child.best;
+    entry.len = parent->len + edge.len;
+    memcpy(entry.text, parent->text, parent->len);
+    memcpy(entry.text + parent->len, &_dict[edge.label], edge.len);
+    push(&entry);
+  }
+
+  return true;
+}
+
+uint8_t IKPredict::lookup(char const *prefix) {
+  _count = 0;
+  _frontier_count = 0;
+  _dirty = true; // words may not be of current prefix
+  _lookup_count++;
+
+  size_t const n = strlen(prefix);
+  if (_dict == NULL || n > IK_PREDICT_WORD_MAX) {
+    return 0;
+  }
+
+  // walk down the prefix, it may end within an edge label
+  entry_t start;
+  start.offset = DICT_HEADER_SIZE;
+  start.len = 0;
+  node_t node;
+  size_t i = 0;
+
+  while (1) {
+    if (!readNode(start.offset, &node)) {
+      return 0;
+    }
+    if (i == n) {
+      break;
+    }
+
+    uint32_t end;
+    if (!nodeEnd(&node, &end)) {
+      return 0;
+    }
+
+    uint32_t pos = node.edges;
+    edge_t edge;
+    bool found = false;
+    for (uint8_t c = 0; c < node.count && !found; c++) {
+      if (!readEdge(&node, &pos, c == 0, end, &edge)) {
+        return 0;
+      }
+      found = (_dict[edge.label] == (uint8_t)prefix[i]);
+    }
+
+    size_t const cmp = (edge.len < n - i) ? edge.len : n - i;
+    if (!found || 0 != memcmp(&_dict[edge.label], &prefix[i], cmp) ||
+        start.len + edge.len > IK_PREDICT_WORD_MAX) {
+      return 0;
+    }
+
+    memcpy(start.text + start.len, &_dict[edge.label], edge.len);
+    start.len += edge.len;
+    start.offset = edge.child;
+    i += cmp;
+  }
+
+  start.priority = node.best;
+  push(&start);
+
+  // best first: pop most likely entry, a word is taken before a sub tree of
+  // the same frequency
+  uint8_t visits = 0;
+  while (_frontier_count && _count < IK_PREDICT_COUNT &&
+         visits < IK_PREDICT_VISIT_MAX) {
+    uint8_t top = 0;
+    for (uint8_t f = 1; f < _frontier_count; f++) {
+      entry_t const *e = &_frontier[f];
+      if (e->priority > _frontier[top].priority ||
+          (e->priority == _frontier[top].priority && e->offset == 0)) {
+        top = f;
+      }
+    }
+
+    entry_t const entry = _frontier[top];
+    _frontier[top] = _frontier[--_frontier_count];
+
+    if (entry.offset == 0) {
+      memcpy(_words[_count], entry.text, entry.len);
+      _words[_count][entry.len] = 0;
+      _count++;
+      continue;
+    }
+
+    visits++;
+    if (!readNode(entry.offset, &node)) {
+      continue;
+    }
+
+    if (node.freq) {
+      entry_t word = entry;
+      word.offset = 0;
+      word.priority = node.freq;
+      push(&word);
+    }
+
+    pushChildren(&entry, &node);
+  }
+
+  if (visits > _visit_max) {
+    _visit_max = visits;
+  }
+
+  return _count;
+}
@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKPREDICT_H
+#define ADAFRUIT_INTELLIKEYS_IKPREDICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Longest word of the dictionary, must match WORD_MAX of tools/ik_dict.py
+#define IK_PREDICT_WORD_MAX 24
+
+// Number of completions offered for the word being typed
+#define IK_PREDICT_COUNT 4
+
+// Lookup bounds: sub trees waiting to be visited (least likely one is dropped
+// when full) and nodes visited per lookup
+#define IK_PREDICT_FRONTIER 16
+#define IK_PREDICT_VISIT_MAX 64
+
+// Word prediction: completions of the word being typed, most frequent first,
+// from a radix trie dictionary compiled by tools/ik_dict.py. The dictionary is
+// read in place (const array stays in flash). Lookup walks the prefix then
+// visits sub trees best frequency first, both bounded so that lookup time does
+// not depend on dictionary size.
+class IKPredict {
+public:
+  IKPredict();
+
+  // Dictionary must stay valid, return false if its header is invalid
+  bool setDictionary(uint8_t const *dict);
+  bool hasDictionary(void) { return _dict != 0; }
+  uint16_t getWordCount(void);
+  uint32_t getDictionarySize(void) { return _size; }
+
+  // Text before cursor is unknown, next key starts a word
+  void clear(void);
+
+  // Key typed, letters (and ') build the word, backspace removes the last one
+  void record(uint8_t keycode, bool shifted);
+
+  // Word typed so far, NULL if not known e.g after backspace over a word
+  char const *getPrefix(void);
+
+  // Completions of current prefix, looked up when prefix has changed
+  uint8_t getCount(void);
+  char const *getWord(uint8_t index);
+  char const *getCompletion(uint8_t index); // remaining letters of word
+
+  // Look up completions of a lowercase prefix, return number found. Words are
+  // read with getResult() until next lookup.
+  uint8_t lookup(char const *prefix);
+  char const *getResult(uint8_t index) {
+    return (index < _count) ? _words[index] : NULL;
+  }
+
+  // Statistics: lookups done and most nodes visited by one
+  uint32_t getLookupCount(void) { return _lookup_count; }
+  uint8_t getVisitMax(void) { return _visit_max; }
+
+private:
+  typedef struct {
+    uint32_t offset;
+    uint8_t count; // children
+    uint8_t freq;  // 0 if not a word end
+    uint8_t best;  // best frequency of sub tree
+    uint32_t edges;
+  } node_t;
+
+  typedef struct {
+    uint32_t label; // offset of label
+    uint8_t len;
+    uint32_t child;
+  } edge_t;
+
+  typedef struct {
+    uint32_t offset; // node, 0 for a complete word
+    uint8_t priority;
+    uint8_t len;
+    char text[IK_PREDICT_WORD_MAX];
+  } entry_t;
+
+  uint8_t const *_dict;
+  uint32_t _size;
+
+  char _prefix[IK_PREDICT_WORD_MAX + 1];
+  uint8_t _len;
+  bool _valid;
+  bool _dirty;
+
+  char _words[IK_PREDICT_COUNT][IK_PREDICT_WORD_MAX + 1];
+  uint8_t _count;
+
+  entry_t _frontier[IK_PREDICT_FRONTIER];
+  uint8_t _frontier_count;
+
+  uint32_t _lookup_count;
+  uint8_t _visit_max;
+
+  bool readNode(uint32_t offset, node_t *node);
+  bool readEdge(node_t const *node, uint32_t *pos, bool first, uint32_t end,
+                edge_t *edge);
+  bool nodeEnd(node_t const *node, uint32_t *end);
+  void push(entry_t const *entry);
+  bool pushChildren(entry_t const *parent, node_t const *node);
+};
+
+#endif
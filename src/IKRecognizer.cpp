@@ -0,0 +1,165 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "IKRecognizer.h"
+
+IKRecognizer::IKRecognizer() {
+  _flapCount = 0;
+  _settleCount = 0;
+  _lastSettleTime = 0;
+  clearCalibration();
+  reset();
+}
+
+void IKRecognizer::reset(void) {
+  for (uint8_t i = 0; i < IK_NUM_SENSORS; i++) {
+    _value[i] = 0;
+  }
+  _bits = 0;
+  _received = 0;
+
+  _candidate = -1;
+  _candidateTime = 0;
+  _minMargin = 0;
+  _flaps = 0;
+  _settled = -1;
+}
+
+void IKRecognizer::setThresholds(int const *midway) {
+  for (uint8_t i = 0; i < IK_NUM_SENSORS; i++) {
+    _midway[i] = midway[i];
+    _low[i] = midway[i] - IK_RECOGNIZER_HYSTERESIS;
+    _high[i] = midway[i] + IK_RECOGNIZER_HYSTERESIS;
+
+    // re-evaluate with new threshold
+    if (_received & (1u << i)) {
+      if (_value[i] > midway[i]) {
+        _bits |= (uint8_t)(1u << i);
+      } else {
+        _bits &= (uint8_t)~(1u << i);
+      }
+    }
+  }
+}
+
+void IKRecognizer::setCalibration(eeprom_t const *eeprom) {
+  int midway[IK_NUM_SENSORS];
+  for (uint8_t i = 0; i < IK_NUM_SENSORS; i++) {
+    midway[i] =
+        (50 * eeprom->sensorBlack[i] + 50 * eeprom->sensorWhite[i]) / 100;
+  }
+  setThresholds(midway);
+  _calibrated = true;
+}
+
+void IKRecognizer::clearCalibration(void) {
+  int midway[IK_NUM_SENSORS];
+  for (uint8_t i = 0; i < IK_NUM_SENSORS; i++) {
+    midway[i] = IK_RECOGNIZER_DEFAULT_MIDWAY;
+  }
+  setThresholds(midway);
+  _calibrated = false;
+}
+
+// Confidence of current readings: smallest distance from midway
+int IKRecognizer::margin(void) {
+  int m = IK_RECOGNIZER_MARGIN_FULL;
+  for (uint8_t i = 0; i < IK_NUM_SENSORS; i++) {
+    int const d = abs(_value[i] - _midway[i]);
+    if (d < m) {
+      m = d;
+    }
+  }
+  return m;
+}
+
+void IKRecognizer::update(uint8_t sensor, int value, uint32_t now) {
+  if (sensor >= IK_NUM_SENSORS) {
+    return;
+  }
+
+  _value[sensor] = value;
+
+  // initial readings of each sensor are not flaps
+  bool const complete = (_received == (1u << IK_NUM_SENSORS) - 1);
+
+  uint8_t const mask = (uint8_t)(1u << sensor);
+  if (!(_received & mask)) {
+    // first reading: no previous state to hold
+    _received |= mask;
+    if (value > _midway[sensor]) {
+      _bits |= mask;
+    }
+  } else if (value > _high[sensor]) {
+    _bits |= mask;
+  } else if (value < _low[sensor]) {
+    _bits &= (uint8_t)~mask;
+  }
+
+  int const m = margin();
+  if (_bits != _candidate) {
+    if (complete && _candidate >= 0 && _candidate != _settled) {
+      // changed again before settled
+      _flaps++;
+      _flapCount++;
+    }
+    _candidate = _bits;
+    _candidateTime = now;
+    _minMargin = m;
+  } else if (m < _minMargin) {
+    _minMargin = m;
+  }
+}
+
+bool IKRecognizer::settle(uint32_t now, int *overlay) {
+  if (_candidate < 0 || _candidate == _settled) {
+    return false;
+  }
+
+  // settle time from confidence, longer when close to threshold or flapping
+  uint32_t settle_time = IK_RECOGNIZER_SETTLE_MAX;
+  if (_minMargin > IK_RECOGNIZER_HYSTERESIS) {
+    settle_time -= (uint32_t)(_minMargin - IK_RECOGNIZER_HYSTERESIS) *
+                   (IK_RECOGNIZER_SETTLE_MAX - IK_RECOGNIZER_SETTLE_MIN) /
+                   (IK_RECOGNIZER_MARGIN_FULL - IK_RECOGNIZER_HYSTERESIS);
+  }
+  settle_time += (uint32_t)_flaps * IK_RECOGNIZER_FLAP_PENALTY;
+  if (settle_time > IK_RECOGNIZER_SETTLE_MAX) {
+    settle_time = IK_RECOGNIZER_SETTLE_MAX;
+  }
+
+  if (now - _candidateTime < settle_time) {
+    return false;
+  }
+
+  _settled = _candidate;
+  _flaps = 0;
+  _settleCount++;
+  _lastSettleTime = settle_time;
+
+  *overlay = _settled;
+  return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKRECOGNIZER_H
+#define ADAFRUIT_INTELLIKEYS_IKRECOGNIZER_H
+
+#include "intellikeysdefs.h"
+
+// Sensor threshold when there is no calibration
+#define IK_RECOGNIZER_DEFAULT_MIDWAY 150
+
+// Sensor bit is set above midway + hysteresis and cleared below midway -
+// hysteresis, readings in between keep the bit unchanged
+#define IK_RECOGNIZER_HYSTERESIS 8
+
+// Overlay must be stable for settle time (ms) before it is recognized: from
+// IK_RECOGNIZER_SETTLE_MIN when all sensors are at least
+// IK_RECOGNIZER_MARGIN_FULL away from their midway, up to
+// IK_RECOGNIZER_SETTLE_MAX when a sensor is within hysteresis. Each flap
+// (candidate changed again before settled) adds IK_RECOGNIZER_FLAP_PENALTY.
+#define IK_RECOGNIZER_SETTLE_MIN 150
+#define IK_RECOGNIZER_SETTLE_MAX 1000
+#define IK_RECOGNIZER_MARGIN_FULL 40
+#define IK_RECOGNIZER_FLAP_PENALTY 250
+
+// Recognize overlay from its bar code sensors. Thresholds are computed once
+// per calibration, each reading only updates its own sensor bit and the
+// confidence (smallest distance from midway) of the candidate overlay.
+class IKRecognizer {
+public:
+  IKRecognizer();
+
+  void reset(void);
+
+  // Midway of black and white calibration for each sensor
+  void setCalibration(eeprom_t const *eeprom);
+  void clearCalibration(void);
+  bool isCalibrated(void) { return _calibrated; }
+
+  void update(uint8_t sensor, int value, uint32_t now);
+
+  // Return true if a new overlay is settled, its value is stored in overlay
+  bool settle(uint32_t now, int *overlay);
+
+  uint16_t getFlapCount(void) { return _flapCount; }
+  uint16_t getSettleCount(void) { return _settleCount; }
+  uint32_t getLastSettleTime(void) { return _lastSettleTime; }
+
+private:
+  int _value[IK_NUM_SENSORS];
+  int _low[IK_NUM_SENSORS];
+  int _high[IK_NUM_SENSORS];
+  int _midway[IK_NUM_SENSORS];
+  bool _calibrated;
+
+  uint8_t _bits;     // sensor bits, IK_NUM_SENSORS bits
+  uint8_t _received; // sensors with at least one reading
+
+  int _candidate;          // overlay value from current bits
+  uint32_t _candidateTime; // when candidate last changed
+  int _minMargin;          // lowest confidence since candidate changed
+  uint8_t _flaps;          // flaps since last settled
+  int _settled;
+
+  uint16_t _flapCount;
+  uint16_t _settleCount;
+  uint32_t _lastSettleTime; // settle time used by last settle
+
+  void setThresholds(int const *midway);
+  int margin(void);
+};
+
+#endif
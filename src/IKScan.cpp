@@ -0,0 +1,209 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "IKScan.h"
+
+IKScan::IKScan(IKTimer *timer, uint16_t timer_id) {
+  _timer = timer;
+  _timer_id = timer_id;
+  _interval = IK_SCAN_INTERVAL;
+  _auto = true;
+  _state = IK_SCAN_IDLE;
+  _row = _pos = _cycles = 0;
+  _deadline = _deadline_us = 0;
+  build(NULL);
+  clearStats();
+}
+
+void IKScan::clearStats(void) {
+  _step_count = 0;
+  _overrun_count = 0;
+  _jitter_max = 0;
+  _jitter_avg = 0;
+}
+
+void IKScan::build(IKOverlay *overlay) {
+  stop();
+
+  _row_count = 0;
+  uint16_t count = 0;
+  uint16_t prev_start = 0;
+  uint8_t prev_len = 0;
+
+  for (uint8_t row = 0; overlay && row < IK_RESOLUTION_Y; row++) {
+    uint16_t const start = count;
+
+    for (uint8_t col = 0; col < IK_RESOLUTION_X; col++) {
+      uint8_t const key_id = overlay->getKeyId(row, col);
+      if (key_id == 0 || overlay->isTrackpadKey(key_id) ||
+          memchr(&_keys[start], key_id, count - start)) {
+        continue;
+      }
+      _keys[count++] = key_id;
+    }
+
+    uint8_t const len = (uint8_t)(count - start);
+    if (len == 0 || (len == prev_len && memcmp(&_keys[prev_start],
+                                               &_keys[start], len) == 0)) {
+      count = start; // empty or same keys as row above
+      continue;
+    }
+
+    _row_start[_row_count++] = start;
+    prev_start = start;
+    prev_len = len;
+  }
+
+  _row_start[_row_count] = count;
+}
+
+void IKScan::stop(void) {
+  _timer->cancel(_timer_id);
+  _state = IK_SCAN_IDLE;
+  _row = _pos = _cycles = 0;
+}
+
+// Next auto step is one interval from now
+void IKScan::schedule(uint32_t now, uint32_t now_us) {
+  _deadline = now + _interval;
+  _deadline_us = now_us + (uint32_t)_interval * 1000;
+  if (_auto) {
+    _timer->start(_timer_id, _deadline);
+  }
+}
+
+void IKScan::scanRows(uint8_t pos, uint32_t now, uint32_t now_us) {
+  _state = IK_SCAN_ROWS;
+  _pos = pos;
+  _cycles = 0;
+  schedule(now, now_us);
+}
+
+uint8_t IKScan::select(uint32_t now, uint32_t now_us) {
+  switch (_state) {
+  case IK_SCAN_IDLE:
+    if (_row_count) {
+      scanRows(0, now, now_us);
+    }
+    return 0;
+
+  case IK_SCAN_ROWS:
+    _row = _pos;
+    if (rowLength(_row) == 1) {
+      // nothing to choose from, row is the key
+      scanRows(0, now, now_us);
+      return _keys[_row_start[_row]];
+    }
+    _state = IK_SCAN_KEYS;
+    _pos = 0;
+    _cycles = 0;
+    schedule(now, now_us);
+    return 0;
+
+  case IK_SCAN_KEYS: {
+    uint8_t const key_id = getKey();
+    scanRows(0, now, now_us);
+    return key_id;
+  }
+
+  default:
+    return 0;
+  }
+}
+
+// Move highlight to next row or key, give up after a few passes without
+// selection when scanning automatically
+void IKScan::advance(void) {
+  if (_state == IK_SCAN_ROWS) {
+    if (++_pos < _row_count) {
+      return;
+    }
+    _pos = 0;
+    if (_auto && ++_cycles >= IK_SCAN_ROW_CYCLES) {
+      stop();
+    }
+  } else if (_state == IK_SCAN_KEYS) {
+    if (++_pos < rowLength(_row)) {
+      return;
+    }
+    _pos = 0;
+    if (_auto && ++_cycles >= IK_SCAN_KEY_CYCLES) {
+      // back to rows, starting with the one just scanned
+      _state = IK_SCAN_ROWS;
+      _pos = _row;
+      _cycles = 0;
+    }
+  }
+}
+
+bool IKScan::step(uint32_t now, uint32_t now_us) {
+  if (_state == IK_SCAN_IDLE) {
+    select(now, now_us);
+    return _state != IK_SCAN_IDLE;
+  }
+
+  advance();
+  if (_state != IK_SCAN_IDLE) {
+    schedule(now, now_us);
+  }
+  return true;
+}
+
+bool IKScan::timeout(uint32_t now, uint32_t now_us) {
+  if (_state == IK_SCAN_IDLE || !_auto) {
+    return false;
+  }
+
+  // timer expires on the ms tick of the deadline, it can be up to 1 ms early
+  // in us
+  int32_t const diff = (int32_t)(now_us - _deadline_us);
+  uint32_t const jitter = (uint32_t)((diff < 0) ? -diff : diff);
+  if (_step_count++ == 0) {
+    _jitter_avg = jitter << 4;
+  } else {
+    _jitter_avg = _jitter_avg - (_jitter_avg >> 3) + (jitter << 1);
+  }
+  if (jitter > _jitter_max) {
+    _jitter_max = jitter;
+  }
+
+  advance();
+  if (_state == IK_SCAN_IDLE) {
+    return true;
+  }
+
+  // keep the cadence of the deadlines, unless a whole interval is missed
+  _deadline += _interval;
+  _deadline_us += (uint32_t)_interval * 1000;
+  if ((int32_t)(now - _deadline) >= 0) {
+    _overrun_count++;
+    _deadline = now + _interval;
+    _deadline_us = now_us + (uint32_t)_interval * 1000;
+  }
+  _timer->start(_timer_id, _deadline);
+
+  return true;
+}
@@ -0,0 +1,132 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKSCAN_H
+#define ADAFRUIT_INTELLIKEYS_IKSCAN_H
+
+#include "IKOverlay.h"
+#include "IKTimer.h"
+
+// Default time (ms) each row or key stays highlighted
+#define IK_SCAN_INTERVAL 1000
+
+// Shortest highlight time (ms) accepted by setInterval()
+#define IK_SCAN_INTERVAL_MIN 100
+
+// Scanning stops after this many passes over all rows without selection, and
+// goes back to row scanning after this many passes over keys of a row
+#define IK_SCAN_ROW_CYCLES 3
+#define IK_SCAN_KEY_CYCLES 2
+
+enum { IK_SCAN_IDLE = 0, IK_SCAN_ROWS, IK_SCAN_KEYS };
+
+// Row/column scanning of the keys of an overlay for switch users. Scan rows
+// are the membrane rows with their distinct keys, identical consecutive rows
+// (e.g from keys taller than one cell) are merged. Rows are highlighted in
+// turn, select picks the highlighted row then its keys are highlighted, select
+// again picks the key.
+//
+// Highlight moves on timer (auto scan) or by step() (step scan with a second
+// switch). Each auto step is scheduled from the previous deadline rather than
+// from when it actually ran, so that late steps do not add up; if a whole
+// interval is missed the schedule is restarted from now and counted as
+// overrun. Jitter is the distance (us) between each step and its deadline, it
+// includes the 1 ms tick of IKTimer and the time Periodic() takes to come
+// around.
+class IKScan {
+public:
+  IKScan(IKTimer *timer, uint16_t timer_id);
+
+  // Compute scan rows of overlay (NULL for none), stop scanning
+  void build(IKOverlay *overlay);
+
+  void setInterval(uint16_t ms) {
+    _interval = (ms < IK_SCAN_INTERVAL_MIN) ? IK_SCAN_INTERVAL_MIN : ms;
+  }
+  uint16_t getInterval(void) { return _interval; }
+  void setAutoStep(bool enabled) { _auto = enabled; }
+
+  // Select switch pressed: start scanning, pick highlighted row or key.
+  // Return selected key id, 0 if none.
+  uint8_t select(uint32_t now, uint32_t now_us);
+  // Step switch pressed or timer expired, return true if highlight moved
+  bool step(uint32_t now, uint32_t now_us);
+  bool timeout(uint32_t now, uint32_t now_us);
+  void stop(void);
+
+  uint8_t getState(void) { return _state; }
+  uint8_t getRowCount(void) { return _row_count; }
+  uint8_t const *getRowKeys(uint8_t row, uint8_t *count) {
+    *count = (uint8_t)(_row_start[row + 1] - _row_start[row]);
+    return &_keys[_row_start[row]];
+  }
+
+  // Highlighted row (or the selected one while scanning keys), position of
+  // highlighted row or key, highlighted key id (0 while scanning rows)
+  uint8_t getRow(void) { return (_state == IK_SCAN_KEYS) ? _row : _pos; }
+  uint8_t getPosition(void) { return _pos; }
+  uint8_t getKey(void) {
+    return (_state == IK_SCAN_KEYS) ? _keys[_row_start[_row] + _pos] : 0;
+  }
+
+  // Timing statistics of auto steps, jitter in us
+  uint32_t getStepCount(void) { return _step_count; }
+  uint32_t getOverrunCount(void) { return _overrun_count; }
+  uint32_t getJitterMax(void) { return _jitter_max; }
+  uint32_t getJitterAvg(void) { return _jitter_avg >> 4; }
+  void clearStats(void);
+
+private:
+  IKTimer *_timer;
+  uint16_t _timer_id;
+
+  // keys of row n are _keys[_row_start[n]] to _keys[_row_start[n + 1] - 1]
+  uint8_t _keys[IK_RESOLUTION_X * IK_RESOLUTION_Y];
+  uint16_t _row_start[IK_RESOLUTION_Y + 1];
+  uint8_t _row_count;
+
+  uint8_t _state;
+  uint8_t _row;    // selected row while scanning keys
+  uint8_t _pos;    // highlighted row or key in row
+  uint8_t _cycles; // passes without selection
+  uint16_t _interval;
+  bool _auto;
+
+  uint32_t _deadline; // next auto step, ms and us
+  uint32_t _deadline_us;
+
+  uint32_t _step_count;
+  uint32_t _overrun_count;
+  uint32_t _jitter_max;
+  uint32_t _jitter_avg; // exponential average, in 1/16 us
+
+  void scanRows(uint8_t pos, uint32_t now, uint32_t now_us);
+  void schedule(uint32_t now, uint32_t now_us);
+  void advance(void);
+  uint8_t rowLength(uint8_t row) {
+    return (uint8_t)(_row_start[row + 1] - _row_start[row]);
+  }
+};
+
+#endif
@@ -2,6 +2,10 @@
 //
 //////////////////////////////////////////////////////////////////////
 
+#include <stddef.h>
+
+#include "SdFat.h"
+
 // #include "IKCommon.h"
 #include "IKSettings.h"
 // #include "IKFile.h"
@@ -12,6 +16,8 @@
 
 #define TEXT(_x) (_x)
 
+#define SETTINGS_MAGIC 0x31534b49 // "IKS1"
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 ////////////////////////////////////////////////////////////////////
@@ -65,6 +71,7 @@ IKSettings::IKSettings()
 
 {
   SetToDefault();
+  SetVolume(NULL);
 }
 
 IKSettings::~IKSettings() {}
@@ -131,122 +138,169 @@ bool IKSettings ::operator==(const IKSettings &rhs) {
          (m_bButAllowOverlays == rhs.m_bButAllowOverlays) && true;
 }
 
-bool IKSettings::Read(IKString filename) {
-  //  set to defaults first
-  SetToDefault();
+void IKSettings::SetVolume(FatVolume *vol) {
+  m_vol = vol;
+  m_slot = 1; // first write goes to slot 0
+  m_sequence = 0;
+  m_bStored = false;
+}
 
-#if 0
-	//  load the file
-  bool bLoaded = m_keyMap.Read(filename);
-#else
-  bool bLoaded = false;
-#endif
-
-  // extract loaded values
-
-  if (bLoaded) {
-    m_iResponseRate = GetIntValue(TEXT("Response Rate"));
-    m_iRepeatRate = GetIntValue(TEXT("Repeat Rate"));
-    m_iShiftKeyAction = GetIntValue(TEXT("Shift Key Action"));
-    m_iMouseSpeed = GetIntValue(TEXT("Mouse Speed"));
-    m_iDataSendRate = GetIntValue(TEXT("Data Send Rate"));
-    m_iMakeBreakRate = GetIntValue(TEXT("Make Break Rate"));
-    m_iIndicatorLights =
-        kSettings6lights; // GetIntValue(TEXT("Indicator Lights"));
-
-    m_bRequiredLiftOff = GetBoolValue(TEXT("Required Lift Off"));
-    m_bUseSystemRepeatSettings =
-        GetBoolValue(TEXT("Use System Repeat Settings"));
-    m_iKeySoundVolume = GetIntValue(TEXT("Key Sound Volume"));
-    m_bRepeat = GetBoolValue(TEXT("Repeat"));
-    m_bRepeatLatching = GetBoolValue(TEXT("Repeat Latching"));
-    m_bSmartTyping = GetBoolValue(TEXT("Smart Typing"));
-
-    m_iMode = GetIntValue(TEXT("Mode"));
-    m_iUseThisSwitchSetting = GetIntValue(TEXT("Use This Switch Setting"));
-    m_sUseThisOverlay = GetStringValue(TEXT("Use This Overlay"));
-    m_sLastSent = GetStringValue(TEXT("Last Sent"));
-    m_sLastSentBy = GetStringValue(TEXT("Last Sent By"));
-
-    m_bShowModeWarning = GetBoolValue(TEXT("Show Mode Warning"));
-    m_bButAllowOverlays = GetBoolValue(TEXT("But Allow Overlays"));
+// CRC-32 (IEEE 802.3), bitwise since settings are small and rarely accessed
+static uint32_t crcUpdate(uint32_t crc, uint8_t const *data, uint32_t len) {
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
   }
-
-  return true;
+  return crc;
 }
 
-void IKSettings::Write(IKString filename) {
-  StoreValues();
+#define SLOT_HEADER_SIZE offsetof(ik_settings_slot_t, data)
+#define SLOT_CRC_START offsetof(ik_settings_slot_t, version)
+#define SECTOR_SIZE 512
 
-  //  save the file
-#if 0
-  m_keyMap.Write(filename);
-#endif
+static uint32_t slotCrc(ik_settings_slot_t const *slot) {
+  uint8_t const *bytes = (uint8_t const *)slot;
+  return ~crcUpdate(0xffffffff, bytes + SLOT_CRC_START,
+                    SLOT_HEADER_SIZE - SLOT_CRC_START + slot->size);
 }
 
-void IKSettings::Write() {
-  StoreValues();
+// File position of a slot, slots start on an erase block of the flash. False
+// if file is not laid out as written by IKSettings::Write().
+static bool slotOffset(File32 &file, uint8_t index, uint32_t *offset) {
+  uint32_t first, last;
+  if (file.fileSize() != IK_SETTINGS_FILE_SIZE ||
+      !file.contiguousRange(&first, &last)) {
+    return false;
+  }
 
-  //  save the file
-#if 0
-  m_keyMap.Write();
-#endif
+  uint32_t const per_block = IK_SETTINGS_BLOCK_SIZE / SECTOR_SIZE;
+  *offset = ((per_block - first % per_block) % per_block) * SECTOR_SIZE +
+            (uint32_t)index * IK_SETTINGS_BLOCK_SIZE;
+  return true;
 }
 
-int IKSettings::GetIntValue(TCHAR *pKey) {
-#if 0
-	IKString str = GetStringValue(pKey);
-  return IKUtil::StringToInt(str);
-#else
-  return 0;
-#endif
-}
+// Read and check a slot. Data of an older version may be shorter than
+// ik_settings_data_t, a newer version is rejected.
+static bool readSlot(File32 &file, uint8_t index, ik_settings_slot_t *slot) {
+  memset(slot, 0, sizeof(ik_settings_slot_t));
+  uint32_t offset;
+  if (!slotOffset(file, index, &offset) || !file.seekSet(offset) ||
+      file.read(slot, SLOT_HEADER_SIZE) != (int)SLOT_HEADER_SIZE ||
+      slot->magic != SETTINGS_MAGIC || slot->version > IK_SETTINGS_VERSION ||
+      slot->size > sizeof(ik_settings_data_t) ||
+      file.read(&slot->data, slot->size) != (int)slot->size) {
+    return false;
+  }
 
-void IKSettings::SetIntValue(TCHAR *pKey, int value) {
-#if 0
-  m_keyMap.SetValue(pKey,value);
-#endif
+  return slot->crc == slotCrc(slot);
 }
 
-bool IKSettings::GetBoolValue(TCHAR *pKey) {
-#if 0
-	IKString str = GetStringValue(pKey);
-	if(str.Compare(TEXT("true"))==0)
+bool IKSettings::Read(IKString filename) {
+  //  set to defaults first
+  SetToDefault();
+  m_slot = 1; // first write goes to slot 0
+  m_sequence = 0;
+  m_bStored = false;
 
-		return true;
+  if (m_vol == NULL) {
+    return false;
+  }
 
-	if(str.Compare(TEXT("TRUE"))==0)
+  File32 file = m_vol->open(filename, O_RDONLY);
+  if (!file) {
+    return false;
+  }
 
-		return true;
+  ik_settings_slot_t slots[2];
+  bool valid[2];
+  for (uint8_t i = 0; i < 2; i++) {
+    valid[i] = readSlot(file, i, &slots[i]);
+  }
+  file.close();
 
-#endif
-  return false;
-}
+  if (!valid[0] && !valid[1]) {
+    return false;
+  }
 
-void IKSettings::SetBoolValue(TCHAR *pKey, bool bValue) {
-#if 0
-  if (bValue)
-		SetStringValue ( pKey, TEXT("TRUE"));
-	else
-		SetStringValue ( pKey, TEXT("FALSE"));
-#endif
-}
+  uint8_t slot = valid[0] ? 0 : 1;
+  if (valid[0] && valid[1] &&
+      (int32_t)(slots[1].sequence - slots[0].sequence) > 0) {
+    slot = 1;
+  }
+
+  // fields missing from an older version keep their default
+  ik_settings_data_t data;
+  StoreValues(&data);
+  uint16_t const size = slots[slot].size;
+  memcpy(&data, &slots[slot].data,
+         (size < sizeof(data)) ? size : sizeof(data));
+  LoadValues(&data);
+
+  m_slot = slot;
+  m_sequence = slots[slot].sequence;
+  m_stored = data;
+  m_bStored = (size == sizeof(data));
 
-IKString IKSettings::GetStringValue(TCHAR *pKey) {
-#if 0
-  IKString str = m_keyMap.GetValueString(pKey);
-	return str;
-#else
-  return NULL;
-#endif
+  return true;
 }
 
-void IKSettings::SetStringValue(TCHAR *pKey, TCHAR *pValue) {
-#if 0
-  m_keyMap.Add(pKey,pValue);
-#endif
+bool IKSettings::Read() { return Read(IK_SETTINGS_FILENAME); }
+
+void IKSettings::Write(IKString filename) {
+  if (m_vol == NULL) {
+    return;
+  }
+
+  ik_settings_slot_t slot;
+  memset(&slot, 0, sizeof(slot));
+  StoreValues(&slot.data);
+
+  if (m_bStored && 0 == memcmp(&m_stored, &slot.data, sizeof(slot.data))) {
+    return;
+  }
+
+  uint8_t const target = m_slot ^ 1;
+  slot.magic = SETTINGS_MAGIC;
+  slot.version = IK_SETTINGS_VERSION;
+  slot.size = sizeof(ik_settings_data_t);
+  slot.sequence = m_sequence + 1;
+  slot.crc = slotCrc(&slot);
+
+  File32 file = m_vol->open(filename, O_RDWR | O_CREAT);
+  if (!file) {
+    return;
+  }
+
+  // new or foreign file is allocated once, both slots start empty (invalid)
+  uint32_t offset;
+  bool ok = true;
+  if (!slotOffset(file, 0, &offset)) {
+    static uint8_t const zero[SLOT_HEADER_SIZE] = {0};
+    ok = file.truncate(0) && file.preAllocate(IK_SETTINGS_FILE_SIZE);
+    for (uint8_t i = 0; ok && i < 2; i++) {
+      ok = slotOffset(file, i, &offset) && file.seekSet(offset) &&
+           (file.write(zero, sizeof(zero)) == sizeof(zero));
+    }
+  }
+
+  ok = ok && slotOffset(file, target, &offset) && file.seekSet(offset) &&
+       (file.write(&slot, sizeof(slot)) == sizeof(slot));
+  ok = file.sync() && ok;
+  file.close();
+
+  // on failure the current slot still holds the previous settings
+  if (ok) {
+    m_slot = target;
+    m_sequence = slot.sequence;
+    m_stored = slot.data;
+    m_bStored = true;
+  }
 }
 
+void IKSettings::Write() { Write(IK_SETTINGS_FILENAME); }
+
 void IKSettings::SetToDefault(bool bFeatureReset /*=false*/) {
   m_iResponseRate = kSettingsRateHigh;
   m_bRequiredLiftOff = false;
@@ -273,34 +327,63 @@ void IKSettings::SetToDefault(bool bFeatureReset /*=false*/) {
   }
 }
 
-void IKSettings::StoreValues() {
-  //  store new values
-#if 0
-	SetIntValue  ( TEXT("Repeat Rate"),					m_iRepeatRate);
-	SetIntValue  ( TEXT("Shift Key Action"),			m_iShiftKeyAction);
-	SetIntValue  ( TEXT("Response Rate"),				m_iResponseRate);
-	SetIntValue  ( TEXT("Mouse Speed"),					m_iMouseSpeed);
-	SetIntValue  ( TEXT("Data Send Rate"),				m_iDataSendRate);
-	SetIntValue  ( TEXT("Make Break Rate"),				m_iMakeBreakRate);
-	SetIntValue  ( TEXT("Indicator Lights"),			m_iIndicatorLights);
-	SetIntValue  ( TEXT("Make Break Rate"),				m_iDataSendRate);
-
-	SetBoolValue ( TEXT("Required Lift Off"),			m_bRequiredLiftOff);
-	SetBoolValue ( TEXT("Use System Repeat Settings"),	m_bUseSystemRepeatSettings);
-	SetIntValue  ( TEXT("Key Sound Volume"),			m_iKeySoundVolume);
-	SetBoolValue ( TEXT("Repeat"),						m_bRepeat);
-	SetBoolValue ( TEXT("Repeat Latching"),				m_bRepeatLatching);
-	SetBoolValue ( TEXT("Smart Typing"),				m_bSmartTyping);
-
-	SetIntValue    ( TEXT("Mode"), m_iMode );
-	SetIntValue    ( TEXT("Use This Switch Setting"),	m_iUseThisSwitchSetting );
-	SetStringValue ( TEXT("Use This Overlay"),			m_sUseThisOverlay );
-	SetStringValue ( TEXT("Last Sent"),					m_sLastSent );
-	SetStringValue ( TEXT("Last Sent By"),				m_sLastSentBy );
-
-	SetBoolValue   ( TEXT("Show Mode Warning"),			m_bShowModeWarning );
-	SetBoolValue   ( TEXT("But Allow Overlays"),		m_bButAllowOverlays );
-#endif
+// Strings (overlay names of the OpenIKeys control panel) are not stored
+void IKSettings::StoreValues(ik_settings_data_t *data) {
+  memset(data, 0, sizeof(ik_settings_data_t));
+  data->response_rate = (uint8_t)m_iResponseRate;
+  data->required_lift_off = m_bRequiredLiftOff;
+  data->repeat_rate = (uint8_t)m_iRepeatRate;
+  data->repeat = m_bRepeat;
+  data->repeat_latching = m_bRepeatLatching;
+  data->shift_key_action = (uint8_t)m_iShiftKeyAction;
+  data->mouse_speed = (uint8_t)m_iMouseSpeed;
+  data->smart_typing = m_bSmartTyping;
+  data->data_send_rate = (uint8_t)m_iDataSendRate;
+  data->make_break_rate = (uint8_t)m_iMakeBreakRate;
+  data->indicator_lights = (uint8_t)m_iIndicatorLights;
+  data->key_sound_volume = (uint8_t)m_iKeySoundVolume;
+  data->use_this_switch_setting = (uint8_t)m_iUseThisSwitchSetting;
+  data->use_system_repeat_settings = m_bUseSystemRepeatSettings;
+  data->mode = (uint8_t)m_iMode;
+  data->show_mode_warning = m_bShowModeWarning;
+  data->but_allow_overlays = m_bButAllowOverlays;
+}
+
+// Stored value if it is in range, otherwise current (default) one
+static int loadValue(uint8_t value, int low, int high, int current) {
+  return (value >= low && value <= high) ? value : current;
+}
+
+void IKSettings::LoadValues(ik_settings_data_t const *data) {
+  m_iResponseRate = loadValue(data->response_rate, kSettingsRateLow,
+                              kSettingsRateHigh, m_iResponseRate);
+  m_bRequiredLiftOff = data->required_lift_off != 0;
+  m_iRepeatRate = loadValue(data->repeat_rate, kSettingsRateLow,
+                            kSettingsRateHigh, m_iRepeatRate);
+  m_bRepeat = data->repeat != 0;
+  m_bRepeatLatching = data->repeat_latching != 0;
+  m_iShiftKeyAction =
+      loadValue(data->shift_key_action, kSettingsShiftLatching,
+                kSettingsShiftNoLatch, m_iShiftKeyAction);
+  m_iMouseSpeed = loadValue(data->mouse_speed, kSettingsRateLow,
+                            kSettingsRateHigh, m_iMouseSpeed);
+  m_bSmartTyping = data->smart_typing != 0;
+  m_iDataSendRate = loadValue(data->data_send_rate, kSettingsRateLow,
+                              kSettingsRateHigh, m_iDataSendRate);
+  m_iMakeBreakRate = loadValue(data->make_break_rate, kSettingsRateLow,
+                               kSettingsRateHigh, m_iMakeBreakRate);
+  m_iIndicatorLights =
+      loadValue(data->indicator_lights, kSettings3lights, kSettings6lights,
+                m_iIndicatorLights);
+  m_iKeySoundVolume =
+      loadValue(data->key_sound_volume, kSettingsKeysoundOff,
+                kSettingsKeysound4, m_iKeySoundVolume);
+  m_iUseThisSwitchSetting = data->use_this_switch_setting;
+  m_bUseSystemRepeatSettings = data->use_system_repeat_settings != 0;
+  m_iMode = loadValue(data->mode, kSettingsModeLastSentOverlay,
+                      kSettingsModeDiscover, m_iMode);
+  m_bShowModeWarning = data->show_mode_warning != 0;
+  m_bButAllowOverlays = data->but_allow_overlays != 0;
 }
 
 //////////////////////////////////
@@ -334,4 +417,7 @@ IKSettings::IKSettings(const IKSettings &src) {
 
   m_bShowModeWarning = src.m_bShowModeWarning;
   m_bButAllowOverlays = src.m_bButAllowOverlays;
+
+  //  a copy is not bound to the settings file
+  SetVolume(NULL);
 }
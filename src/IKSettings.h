@@ -16,6 +16,55 @@
 #define IKString const char *
 #define TCHAR const char
 
+class FatVolume;
+
+// Settings are stored in flash filesystem as a binary blob with fixed layout.
+// The file holds 2 slots, each in its own erase block of the flash: a write
+// goes to the slot not holding the current settings, so a power loss during
+// write leaves the previous settings intact. Boot loads the newest slot with a
+// valid CRC. The file is allocated contiguous once at full size so that a
+// write only changes data of the target slot, not FAT or directory entry.
+#define IK_SETTINGS_FILENAME "/ik_settings.bin"
+
+// Flash erase block, slots are aligned to it. File has a spare block to align
+// the first slot whatever sector the file starts at.
+#define IK_SETTINGS_BLOCK_SIZE 4096
+#define IK_SETTINGS_FILE_SIZE (3 * IK_SETTINGS_BLOCK_SIZE)
+
+// Bump when fields are changed, new fields are added at end of
+// ik_settings_data_t. Missing fields of an older blob keep their default, a
+// blob of a newer version is ignored.
+#define IK_SETTINGS_VERSION 1
+
+typedef struct __attribute__((packed)) {
+  uint8_t response_rate;
+  uint8_t required_lift_off;
+  uint8_t repeat_rate;
+  uint8_t repeat;
+  uint8_t repeat_latching;
+  uint8_t shift_key_action;
+  uint8_t mouse_speed;
+  uint8_t smart_typing;
+  uint8_t data_send_rate;
+  uint8_t make_break_rate;
+  uint8_t indicator_lights;
+  uint8_t key_sound_volume;
+  uint8_t use_this_switch_setting;
+  uint8_t use_system_repeat_settings;
+  uint8_t mode;
+  uint8_t show_mode_warning;
+  uint8_t but_allow_overlays;
+} ik_settings_data_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint32_t crc;      // CRC-32 of the rest of header and data (size bytes)
+  uint16_t version;  // IK_SETTINGS_VERSION of writer
+  uint16_t size;     // of data
+  uint32_t sequence; // incremented by each write, newest slot wins
+  ik_settings_data_t data;
+} ik_settings_slot_t;
+
 enum { kSettingsRateLow = 1, kSettingsRateHigh = 15 };
 
 enum {
@@ -48,19 +97,19 @@ public:
 
   static IKSettings *GetSettings();
 
+  // Flash filesystem holding the settings file, NULL to disable persistence
+  void SetVolume(FatVolume *vol);
+
+  // Write is skipped when stored settings are unchanged. Read returns false
+  // (and keeps defaults) if there are no valid stored settings.
   void Write(IKString filename);
   void Write();
   bool Read(IKString filename);
+  bool Read();
   void SetToDefault(bool bFeatureReset = false);
   IKSettings &operator=(const IKSettings &rhs);
   bool operator==(const IKSettings &rhs);
   bool operator!=(const IKSettings &rhs);
-  int GetIntValue(TCHAR *pKey);
-  void SetIntValue(TCHAR *pKey, int value);
-  bool GetBoolValue(TCHAR *pKey);
-  void SetBoolValue(TCHAR *pKey, bool value);
-  IKString GetStringValue(TCHAR *pKey);
-  void SetStringValue(TCHAR *pKey, TCHAR *pValue);
   IKSettings(const IKSettings &src); //  copy ctor
 
   int m_iResponseRate;
@@ -86,7 +135,14 @@ public:
   bool m_bButAllowOverlays;
 
 private:
-  void StoreValues();
+  FatVolume *m_vol;
+  uint8_t m_slot;      // slot holding current settings
+  uint32_t m_sequence; // of current slot
+  bool m_bStored;      // m_stored is what the file holds
+  ik_settings_data_t m_stored;
+
+  void StoreValues(ik_settings_data_t *data);
+  void LoadValues(ik_settings_data_t const *data);
 };
 
 #endif // !defined(AFX_IKSETTINGS_H__2529EB67_16DF_4B22_B49F_7BE997C36C53__INCLUDED_)
@@ -0,0 +1,145 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "IKSmartTyping.h"
+#include "class/hid/hid.h"
+
+typedef struct {
+  uint8_t key;   // class of key being typed
+  uint8_t prev2; // class of key before previous, 0 for any
+  uint8_t prev1; // class of previous key
+  uint8_t action;
+} smart_rule_t;
+
+// First matching rule wins
+static smart_rule_t const smartRules[] = {
+    // "word ," -> "word,"
+    {IK_SMART_SENTENCE_END | IK_SMART_PUNCT, IK_SMART_LETTER | IK_SMART_DIGIT,
+     IK_SMART_SPACE, IK_SMART_ERASE_SPACE},
+
+    // " i " -> " I "
+    {IK_SMART_SPACE | IK_SMART_SENTENCE_END | IK_SMART_PUNCT,
+     IK_SMART_SPACE | IK_SMART_START, IK_SMART_LONE_I, IK_SMART_CAPITALIZE_I},
+
+    // "end.next" -> "end. Next"
+    {IK_SMART_LETTER, IK_SMART_LETTER, IK_SMART_SENTENCE_END,
+     IK_SMART_ADD_SPACE | IK_SMART_CAPITALIZE},
+
+    // "one,two" -> "one, two"
+    {IK_SMART_LETTER, IK_SMART_LETTER | IK_SMART_DIGIT, IK_SMART_PUNCT,
+     IK_SMART_ADD_SPACE},
+
+    // "end. next" -> "end. Next"
+    {IK_SMART_LETTER, IK_SMART_SENTENCE_END, IK_SMART_SPACE,
+     IK_SMART_CAPITALIZE},
+
+    // first letter of a line
+    {IK_SMART_LETTER, 0, IK_SMART_START, IK_SMART_CAPITALIZE},
+};
+
+IKSmartTyping::IKSmartTyping() { clear(); }
+
+void IKSmartTyping::clear(void) {
+  _head = 0;
+  _count = 0;
+}
+
+uint8_t IKSmartTyping::classify(uint8_t keycode, bool shifted) {
+  if (keycode >= HID_KEY_A && keycode <= HID_KEY_Z) {
+    if (keycode == HID_KEY_I && !shifted) {
+      return IK_SMART_LETTER | IK_SMART_LONE_I;
+    }
+    return IK_SMART_LETTER;
+  }
+
+  switch (keycode) {
+  case HID_KEY_1:
+    return shifted ? IK_SMART_SENTENCE_END : IK_SMART_DIGIT;
+  case HID_KEY_PERIOD:
+    return shifted ? IK_SMART_OTHER : IK_SMART_SENTENCE_END;
+  case HID_KEY_SLASH:
+    return shifted ? IK_SMART_SENTENCE_END : IK_SMART_OTHER;
+  case HID_KEY_COMMA:
+    return shifted ? IK_SMART_OTHER : IK_SMART_PUNCT;
+  case HID_KEY_SEMICOLON:
+    return IK_SMART_PUNCT;
+  case HID_KEY_SPACE:
+    return IK_SMART_SPACE;
+  case HID_KEY_ENTER:
+  case HID_KEY_KEYPAD_ENTER:
+    return IK_SMART_START;
+  default:
+    break;
+  }
+
+  if (keycode >= HID_KEY_2 && keycode <= HID_KEY_0) {
+    return shifted ? IK_SMART_OTHER : IK_SMART_DIGIT;
+  }
+
+  return IK_SMART_OTHER;
+}
+
+uint8_t IKSmartTyping::getLast(uint8_t back) {
+  if (back >= _count) {
+    return IK_SMART_OTHER;
+  }
+  return _class[(_head - 1 - back) & (IK_SMART_RING_SIZE - 1)];
+}
+
+uint8_t IKSmartTyping::lookup(uint8_t keycode, bool shifted) {
+  uint8_t const key = classify(keycode, shifted);
+  uint8_t const prev1 = getLast(0);
+  uint8_t const prev2 = getLast(1);
+
+  for (uint8_t i = 0; i < sizeof(smartRules) / sizeof(smartRules[0]); i++) {
+    smart_rule_t const *rule = &smartRules[i];
+    if ((key & rule->key) && (prev1 & rule->prev1) &&
+        (rule->prev2 == 0 || (prev2 & rule->prev2))) {
+      uint8_t action = rule->action;
+      if (shifted) {
+        action &= (uint8_t)~IK_SMART_CAPITALIZE;
+      }
+      return action;
+    }
+  }
+
+  return 0;
+}
+
+void IKSmartTyping::record(uint8_t keycode, bool shifted) {
+  if (keycode == HID_KEY_BACKSPACE) {
+    if (_count) {
+      _head = (_head - 1) & (IK_SMART_RING_SIZE - 1);
+      _count--;
+    }
+    return;
+  }
+
+  // oldest key is overwritten when ring is full
+  _class[_head] = classify(keycode, shifted);
+  _head = (_head + 1) & (IK_SMART_RING_SIZE - 1);
+  if (_count < IK_SMART_RING_SIZE) {
+    _count++;
+  }
+}
@@ -0,0 +1,81 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKSMARTTYPING_H
+#define ADAFRUIT_INTELLIKEYS_IKSMARTTYPING_H
+
+#include <stdint.h>
+
+// Number of recent keystrokes kept, must be power of 2
+#define IK_SMART_RING_SIZE 16
+
+// Keystroke classes, bit mask so that a rule can match several classes.
+// Unknown text (e.g after cursor is moved) reads as IK_SMART_OTHER.
+enum {
+  IK_SMART_LETTER = (1u << 0),
+  IK_SMART_LONE_I = (1u << 1), // lowercase i, also a letter
+  IK_SMART_DIGIT = (1u << 2),
+  IK_SMART_SPACE = (1u << 3),
+  IK_SMART_SENTENCE_END = (1u << 4), // . ? !
+  IK_SMART_PUNCT = (1u << 5),        // , ; :
+  IK_SMART_START = (1u << 6),        // new line
+  IK_SMART_OTHER = (1u << 7),
+};
+
+// Actions of a matched rule, done before the key is typed
+enum {
+  IK_SMART_ERASE_SPACE = (1u << 0), // backspace over previous space
+  IK_SMART_ADD_SPACE = (1u << 1),   // space before the key
+  IK_SMART_CAPITALIZE = (1u << 2),  // type the key shifted
+  IK_SMART_CAPITALIZE_I = (1u << 3) // retype previous i as I
+};
+
+// Smart typing: a small table of rules matched against the last two
+// keystrokes of a ring of recently typed keys, e.g auto space after
+// punctuation and capital letter at start of sentence. Matching and recording
+// are O(1) per keystroke.
+class IKSmartTyping {
+public:
+  IKSmartTyping();
+
+  void clear(void);
+
+  // Action for the key (HID keycode) about to be typed, 0 if no rule matches
+  uint8_t lookup(uint8_t keycode, bool shifted);
+
+  // Key typed, backspace removes the last key
+  void record(uint8_t keycode, bool shifted);
+
+  // Class of last typed key
+  uint8_t getLast(uint8_t back = 0);
+
+  static uint8_t classify(uint8_t keycode, bool shifted);
+
+private:
+  uint8_t _class[IK_SMART_RING_SIZE];
+  uint8_t _head; // next slot
+  uint8_t _count;
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "IKTimer.h"
+
+IKTimer::IKTimer() {
+  _time = 0;
+  clear();
+}
+
+void IKTimer::clear(void) {
+  memset(_list, LIST_NONE, sizeof(_list));
+  memset(_head, 0xff, sizeof(_head));
+  _count = 0;
+}
+
+void IKTimer::link(uint16_t id, uint8_t list) {
+  uint16_t const head = _head[list];
+  _prev[id] = NIL;
+  _next[id] = head;
+  if (head != NIL) {
+    _prev[head] = id;
+  }
+  _head[list] = id;
+  _list[id] = list;
+}
+
+void IKTimer::unlink(uint16_t id) {
+  uint16_t const prev = _prev[id];
+  uint16_t const next = _next[id];
+
+  if (prev != NIL) {
+    _next[prev] = next;
+  } else {
+    _head[_list[id]] = next;
+  }
+
+  if (next != NIL) {
+    _prev[next] = prev;
+  }
+
+  _list[id] = LIST_NONE;
+}
+
+void IKTimer::start(uint16_t id, uint32_t expire) {
+  if (id >= IK_TIMER_MAX) {
+    return;
+  }
+
+  if (_list[id] != LIST_NONE) {
+    unlink(id);
+  } else {
+    _count++;
+  }
+
+  _expire[id] = expire;
+
+  if ((int32_t)(expire - _time) <= 0) {
+    link(id, LIST_READY);
+  } else {
+    link(id, (uint8_t)(expire & (IK_TIMER_WHEEL_SIZE - 1)));
+  }
+}
+
+void IKTimer::cancel(uint16_t id) {
+  if (id >= IK_TIMER_MAX || _list[id] == LIST_NONE) {
+    return;
+  }
+
+  unlink(id);
+  _count--;
+}
+
+// Move timers due by now from elapsed slots to ready list
+void IKTimer::advance(uint32_t now) {
+  uint32_t elapsed = now - _time;
+  if ((int32_t)elapsed <= 0) {
+    return;
+  }
+
+  // nothing pending, just catch up
+  if (_count == 0) {
+    _time = now;
+    return;
+  }
+
+  // after one revolution all slots are visited
+  if (elapsed > IK_TIMER_WHEEL_SIZE) {
+    elapsed = IK_TIMER_WHEEL_SIZE;
+  }
+
+  for (uint32_t i = 1; i <= elapsed; i++) {
+    uint8_t const slot = (uint8_t)((_time + i) & (IK_TIMER_WHEEL_SIZE - 1));
+    uint16_t id = _head[slot];
+    while (id != NIL) {
+      uint16_t const next = _next[id];
+      if ((int32_t)(_expire[id] - now) <= 0) {
+        unlink(id);
+        link(id, LIST_READY);
+      }
+      id = next;
+    }
+  }
+
+  _time = now;
+}
+
+bool IKTimer::poll(uint32_t now, uint16_t *id) {
+  advance(now);
+
+  uint16_t const ready = _head[LIST_READY];
+  if (ready == NIL) {
+    return false;
+  }
+
+  unlink(ready);
+  _count--;
+
+  *id = ready;
+  return true;
+}
@@ -0,0 +1,81 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKTIMER_H
+#define ADAFRUIT_INTELLIKEYS_IKTIMER_H
+
+#include <stdint.h>
+
+// Number of timer ids, each id can be pending at most once
+#ifndef IK_TIMER_MAX
+#define IK_TIMER_MAX 520
+#endif
+
+// Number of wheel slots (1 ms each), must be power of 2. Timers further than
+// one revolution stay in their slot until the wheel comes around enough times.
+#define IK_TIMER_WHEEL_SIZE 64
+
+// Hashed timing wheel with 1 ms tick. Timers are identified by a small id
+// chosen by the caller (e.g key id) and linked into the slot of their
+// deadline, so that start and cancel are O(1) and advancing the wheel only
+// looks at timers due in the elapsed slots, not at every pending timer.
+class IKTimer {
+public:
+  IKTimer();
+
+  void clear(void);
+
+  // (Re)start timer id to expire at absolute time (ms)
+  void start(uint16_t id, uint32_t expire);
+  void cancel(uint16_t id);
+  bool isPending(uint16_t id) { return _list[id] != LIST_NONE; }
+  uint16_t getCount(void) { return _count; }
+
+  // Get one expired timer id, return false if none. Call repeatedly until it
+  // returns false, expired timer is removed before returned and can be
+  // restarted right away.
+  bool poll(uint32_t now, uint16_t *id);
+
+private:
+  enum {
+    NIL = 0xffff,
+    LIST_READY = IK_TIMER_WHEEL_SIZE,
+    LIST_NONE = 0xff,
+  };
+
+  uint32_t _expire[IK_TIMER_MAX];
+  uint16_t _next[IK_TIMER_MAX];
+  uint16_t _prev[IK_TIMER_MAX];
+  uint8_t _list[IK_TIMER_MAX]; // slot index, ready or none
+
+  uint16_t _head[IK_TIMER_WHEEL_SIZE + 1]; // wheel slots + ready list
+  uint32_t _time;                          // last processed tick
+  uint16_t _count;
+
+  void link(uint16_t id, uint8_t list);
+  void unlink(uint16_t id);
+  void advance(uint32_t now);
+};
+
+#endif
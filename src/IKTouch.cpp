@@ -0,0 +1,149 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "IKTouch.h"
+
+#define CELL(_row, _col) ((uint16_t)(((_row) << 8) | (_col)))
+#define CELL_ROW(_cell) ((_cell) >> 8)
+#define CELL_COL(_cell) ((_cell)&0xff)
+
+#define ROW_MASK ((1ul << IK_RESOLUTION_X) - 1)
+
+IKTouch::IKTouch() { clear(); }
+
+void IKTouch::clear(void) {
+  memset(_rows, 0, sizeof(_rows));
+  _count = 0;
+}
+
+void IKTouch::setCell(int row, int col, bool pressed) {
+  if (pressed) {
+    _rows[row] |= (1ul << col);
+  } else {
+    _rows[row] &= ~(1ul << col);
+  }
+}
+
+uint8_t IKTouch::update(IKOverlay *overlay) {
+  // cells not yet assigned to any blob
+  uint32_t remain[IK_RESOLUTION_Y];
+  memcpy(remain, _rows, sizeof(remain));
+
+  _count = 0;
+  uint16_t tail = 0; // queue end, all blobs share the scratch queue
+
+  for (uint8_t row = 0; row < IK_RESOLUTION_Y; row++) {
+    while (remain[row]) {
+      // seed new blob with the first remaining cell of this row
+      uint8_t const col = __builtin_ctzl(remain[row]);
+      remain[row] &= ~(1ul << col);
+
+      uint16_t const start = tail;
+      uint16_t head = tail;
+      _cells[tail++] = CELL(row, col);
+
+      uint32_t sum_x = 0, sum_y = 0;
+
+      // breadth first flood fill with 8-connectivity
+      while (head < tail) {
+        uint16_t const cell = _cells[head++];
+        int const r = CELL_ROW(cell);
+        int const c = CELL_COL(cell);
+
+        sum_x += c;
+        sum_y += r;
+
+        for (int nr = r - 1; nr <= r + 1; nr++) {
+          if (nr < 0 || nr >= IK_RESOLUTION_Y) {
+            continue;
+          }
+
+          // 3 neighbor columns at once
+          uint32_t neighbor = (c > 0 ? (7ul << (c - 1)) : 3ul) & ROW_MASK;
+          neighbor &= remain[nr];
+          remain[nr] &= ~neighbor;
+
+          while (neighbor) {
+            uint8_t const nc = __builtin_ctzl(neighbor);
+            neighbor &= neighbor - 1;
+            _cells[tail++] = CELL(nr, nc);
+          }
+        }
+      }
+
+      if (_count < IK_TOUCH_MAX) {
+        uint16_t const size = tail - start;
+        ik_touch_t *touch = &_touches[_count++];
+
+        // centroid of cell centers
+        touch->x = (uint16_t)(((sum_x << IK_TOUCH_FRAC_BITS) +
+                               (size << (IK_TOUCH_FRAC_BITS - 1))) /
+                              size);
+        touch->y = (uint16_t)(((sum_y << IK_TOUCH_FRAC_BITS) +
+                               (size << (IK_TOUCH_FRAC_BITS - 1))) /
+                              size);
+        touch->size = size;
+        touch->key_id = overlay ? nearestKey(overlay, start, tail, touch) : 0;
+      }
+    }
+  }
+
+  return _count;
+}
+
+// Key under the centroid, or the key of the blob cell nearest to the centroid
+// if centroid falls between keys.
+uint8_t IKTouch::nearestKey(IKOverlay *overlay, uint16_t start, uint16_t end,
+                            ik_touch_t const *touch) {
+  int const cx = touch->x >> IK_TOUCH_FRAC_BITS;
+  int const cy = touch->y >> IK_TOUCH_FRAC_BITS;
+
+  uint8_t key_id = overlay->getKeyId(cy, cx);
+  if (key_id) {
+    return key_id;
+  }
+
+  uint32_t best_dist = UINT32_MAX;
+  for (uint16_t i = start; i < end; i++) {
+    uint16_t const cell = _cells[i];
+    uint8_t const id = overlay->getKeyId(CELL_ROW(cell), CELL_COL(cell));
+    if (id == 0) {
+      continue;
+    }
+
+    // distance between cell center and centroid, in 1/256 cell
+    int32_t const dx =
+        (int32_t)((CELL_COL(cell) << IK_TOUCH_FRAC_BITS) + 128) - touch->x;
+    int32_t const dy =
+        (int32_t)((CELL_ROW(cell) << IK_TOUCH_FRAC_BITS) + 128) - touch->y;
+    uint32_t const dist = (uint32_t)(dx * dx + dy * dy);
+
+    if (dist < best_dist) {
+      best_dist = dist;
+      key_id = id;
+    }
+  }
+
+  return key_id;
+}
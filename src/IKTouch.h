@@ -0,0 +1,76 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKTOUCH_H
+#define ADAFRUIT_INTELLIKEYS_IKTOUCH_H
+
+#include "IKOverlay.h"
+#include "intellikeysdefs.h"
+
+// maximum number of simultaneous touches (blobs) reported
+#define IK_TOUCH_MAX 10
+
+// centroid is fixed point with 8 fractional bits i.e 1/256 cell
+#define IK_TOUCH_FRAC_BITS 8
+
+typedef struct {
+  uint16_t x;     // centroid column in 1/256 cell
+  uint16_t y;     // centroid row in 1/256 cell
+  uint16_t size;  // number of touched cells
+  uint8_t key_id; // nearest key of the overlay, 0 if none
+} ik_touch_t;
+
+// Track membrane as a bitset (1 bit per cell) and group touched cells into
+// 8-connected blobs. Each blob is a touch with its centroid and size. Cost of
+// update() is proportional to the number of touched cells.
+class IKTouch {
+public:
+  IKTouch();
+
+  void clear(void);
+  void setCell(int row, int col, bool pressed);
+  bool getCell(int row, int col) { return (_rows[row] >> col) & 1u; }
+  uint32_t const *getRows(void) { return _rows; }
+
+  // Find blobs and their nearest key in overlay (can be NULL), return the
+  // number of touches
+  uint8_t update(IKOverlay *overlay);
+
+  uint8_t getCount(void) { return _count; }
+  ik_touch_t const *getTouch(uint8_t idx) { return &_touches[idx]; }
+
+private:
+  uint32_t _rows[IK_RESOLUTION_Y]; // bit n is column n
+
+  ik_touch_t _touches[IK_TOUCH_MAX];
+  uint8_t _count;
+
+  // scratch queue of cells (row << 8 | col) for flood fill
+  uint16_t _cells[IK_RESOLUTION_X * IK_RESOLUTION_Y];
+
+  uint8_t nearestKey(IKOverlay *overlay, uint16_t start, uint16_t end,
+                     ik_touch_t const *touch);
+};
+
+#endif // ADAFRUIT_INTELLIKEYS_IKTOUCH_H
@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "IKUnicode.h"
+#include "IKModifier.h"
+#include "IKUniversal.h"
+
+#define CODE_POINT_INVALID 0xffffffffu
+
+IKUnicode::IKUnicode() {
+  _hit = _miss = 0;
+  setMode(IK_UNICODE_LINUX);
+}
+
+void IKUnicode::setMode(uint8_t mode) {
+  _mode = mode;
+  for (uint8_t i = 0; i < IK_UNICODE_CACHE_SIZE; i++) {
+    _cache[i].code_point = CODE_POINT_INVALID;
+  }
+}
+
+static uint8_t addEvent(ik_key_event_t *events, uint8_t count, uint8_t code,
+                        uint8_t direction) {
+  events[count].code = code;
+  events[count].direction = direction;
+  return count + 1;
+}
+
+static uint8_t addTap(ik_key_event_t *events, uint8_t count, uint8_t code) {
+  count = addEvent(events, count, code, IK_DOWN);
+  return addEvent(events, count, code, IK_UP);
+}
+
+// Tap hex digits of value, at least min_digits, leading zeros skipped
+static uint8_t addHex(ik_key_event_t *events, uint8_t count, uint32_t value,
+                      uint8_t min_digits, bool numpad) {
+  bool started = false;
+  for (int8_t i = 7; i >= 0; i--) {
+    uint8_t const digit = (value >> (i * 4)) & 0x0f;
+    if (!started && digit == 0 && i >= min_digits) {
+      continue;
+    }
+    started = true;
+
+    uint8_t code;
+    if (digit >= 10) {
+      code = (uint8_t)(UNIVERSAL_A + digit - 10);
+    } else if (numpad) {
+      code = (uint8_t)(UNIVERSAL_NUMPAD_0 + digit);
+    } else {
+      code = (uint8_t)(UNIVERSAL_0 + digit);
+    }
+    count = addTap(events, count, code);
+  }
+  return count;
+}
+
+uint8_t IKUnicode::build(uint32_t cp, ik_key_event_t *events) {
+  uint8_t count = 0;
+
+  switch (_mode) {
+  case IK_UNICODE_LINUX:
+    count = addEvent(events, count, UNIVERSAL_CONTROL, IK_DOWN);
+    count = addEvent(events, count, UNIVERSAL_SHIFT, IK_DOWN);
+    count = addTap(events, count, UNIVERSAL_U);
+    count = addEvent(events, count, UNIVERSAL_SHIFT, IK_UP);
+    count = addEvent(events, count, UNIVERSAL_CONTROL, IK_UP);
+    count = addHex(events, count, cp, 1, false);
+    count = addTap(events, count, UNIVERSAL_SPACE);
+    break;
+
+  case IK_UNICODE_WINDOWS:
+    count = addEvent(events, count, UNIVERSAL_ALT, IK_DOWN);
+    count = addTap(events, count, UNIVERSAL_NUMPAD_ADD);
+    count = addHex(events, count, cp, 1, true);
+    count = addEvent(events, count, UNIVERSAL_ALT, IK_UP);
+    break;
+
+  case IK_UNICODE_MACOS:
+    count = addEvent(events, count, UNIVERSAL_OPTION, IK_DOWN);
+    if (cp >= 0x10000) {
+      // surrogate pair
+      uint32_t const v = cp - 0x10000;
+      count = addHex(events, count, 0xd800 + (v >> 10), 4, false);
+      count = addHex(events, count, 0xdc00 + (v & 0x3ff), 4, false);
+    } else {
+      count = addHex(events, count, cp, 4, false);
+    }
+    count = addEvent(events, count, UNIVERSAL_OPTION, IK_UP);
+    break;
+
+  default:
+    break;
+  }
+
+  return count;
+}
+
+uint8_t IKUnicode::getSequence(uint32_t cp, ik_key_event_t const **events) {
+  // surrogates are not characters
+  if (cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+    return 0;
+  }
+
+  entry_t *entry = &_cache[cp % IK_UNICODE_CACHE_SIZE];
+  if (entry->code_point == cp) {
+    _hit++;
+  } else {
+    _miss++;
+    entry->code_point = cp;
+    entry->count = build(cp, entry->events);
+  }
+
+  *events = entry->events;
+  return entry->count;
+}
@@ -0,0 +1,79 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ADAFRUIT_INTELLIKEYS_IKUNICODE_H
+#define ADAFRUIT_INTELLIKEYS_IKUNICODE_H
+
+#include <stdint.h>
+
+// Host method to enter a code point
+enum {
+  IK_UNICODE_LINUX = 0, // Ctrl+Shift+U, hex digits, Space (IBus, GTK)
+  IK_UNICODE_WINDOWS,   // hold Alt, numpad +, hex digits (EnableHexNumpad)
+  IK_UNICODE_MACOS,     // hold Option, UTF-16 hex digits (Unicode Hex Input)
+};
+
+// Number of cached sequences (direct mapped by code point) and maximum number
+// of key events in a sequence
+#define IK_UNICODE_CACHE_SIZE 16
+#define IK_UNICODE_SEQ_MAX 24
+
+typedef struct {
+  uint8_t code;      // universal code
+  uint8_t direction; // IK_DOWN or IK_UP
+} ik_key_event_t;
+
+// Converts code points to key event sequences for the host input method.
+// Sequences are kept in a small cache so that a repeatedly typed character
+// costs a lookup only.
+class IKUnicode {
+public:
+  IKUnicode();
+
+  void setMode(uint8_t mode);
+  uint8_t getMode(void) { return _mode; }
+
+  // Key events typing code point, return number of events (0 if invalid).
+  // Events point into the cache and are valid until the next call.
+  uint8_t getSequence(uint32_t code_point, ik_key_event_t const **events);
+
+  uint32_t getHitCount(void) { return _hit; }
+  uint32_t getMissCount(void) { return _miss; }
+
+private:
+  typedef struct {
+    uint32_t code_point;
+    uint8_t count;
+    ik_key_event_t events[IK_UNICODE_SEQ_MAX];
+  } entry_t;
+
+  entry_t _cache[IK_UNICODE_CACHE_SIZE];
+  uint8_t _mode;
+  uint32_t _hit;
+  uint32_t _miss;
+
+  uint8_t build(uint32_t code_point, ik_key_event_t *events);
+};
+
+#endif
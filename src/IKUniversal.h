@@ -2,6 +2,9 @@
 //  Definitions for all the intellikeys universal codes
 //
 
+#ifndef ADAFRUIT_INTELLIKEYS_IKUNIVERSAL_H
+#define ADAFRUIT_INTELLIKEYS_IKUNIVERSAL_H
+
 #define UNIVERSAL_F1 0x01
 #define UNIVERSAL_F2 0x02
 #define UNIVERSAL_F3 0x03
@@ -345,3 +348,5 @@
 // #define UNIVERSAL_ 0xfd
 // #define UNIVERSAL_ 0xfe
 // #define UNIVERSAL_ 0xff
+
+#endif // ADAFRUIT_INTELLIKEYS_IKUNIVERSAL_H
@@ -0,0 +1,240 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Generated by tools/ik_dict.py from tools/words_en.txt, do not edit
+
+#ifndef ADAFRUIT_INTELLIKEYS_IK_DICT_EN_H
+#define ADAFRUIT_INTELLIKEYS_IK_DICT_EN_H
+
+#include <stdint.h>
+
+static const uint8_t ik_dict_en[2455] = {
+    0x49, 0x4b, 0x44, 0x31, 0x97, 0x09, 0x00, 0x00, 0x41, 0x01, 0x18, 0x00,
+    0x17, 0xff, 0x01, 0x74, 0x01, 0x6f, 0xe4, 0x02, 0x01, 0x61, 0xc7, 0x03,
+    0x01, 0x69, 0x84, 0x05, 0x01, 0x79, 0xbe, 0x05, 0x01, 0x68, 0xe9, 0x05,
+    0x01, 0x77, 0xf1, 0x06, 0x01, 0x66, 0xac, 0x08, 0x01, 0x62, 0xb1, 0x09,
+    0x01, 0x6e, 0xaf, 0x0a, 0x01, 0x63, 0xf9, 0x0a, 0x01, 0x73, 0xf7, 0x0b,
+    0x01, 0x75, 0xe6, 0x0d, 0x01, 0x65, 0x88, 0x0e, 0x01, 0x64, 0xd7, 0x0e,
+    0x01, 0x6d, 0x8a, 0x0f, 0x01, 0x6c, 0x99, 0x10, 0x01, 0x67, 0xa5, 0x11,
+    0x01, 0x70, 0xed, 0x11, 0x01, 0x6b, 0xc7, 0x12, 0x04, 0x76, 0x65, 0x72,
+    0x79, 0xdd, 0x12, 0x04, 0x6a, 0x75, 0x73, 0x74, 0xdf, 0x12, 0x01, 0x72,
+    0xe1, 0x12, 0x08, 0xff, 0x01, 0x68, 0x01, 0x6f, 0xa0, 0x01, 0x01, 0x69,
+    0xc7, 0x01, 0x02, 0x77, 0x6f, 0xd5, 0x01, 0x01, 0x61, 0xd7, 0x01, 0x01,
+    0x65, 0xe4, 0x01, 0x03, 0x75, 0x72, 0x6e, 0xf4, 0x01, 0x01, 0x72, 0xf6,
+    0x01, 0x05, 0xff, 0x01, 0x65, 0x01, 0x61, 0x33, 0x01, 0x69, 0x43, 0x01,
+    0x72, 0x5f, 0x01, 0x6f, 0x6e, 0x86, 0xff, 0xff, 0x01, 0x79, 0x02, 0x72,
+    0x65, 0x19, 0x02, 0x69, 0x72, 0x1b, 0x01, 0x6e, 0x1d, 0x01, 0x6d, 0x1f,
+    0x02, 0x73, 0x65, 0x21, 0x80, 0x7d, 0x80, 0x5b, 0x80, 0x53, 0x80, 0x4d,
+    0x80, 0x4c, 0x80, 0x4b, 0x02, 0x9e, 0x01, 0x74, 0x01, 0x6e, 0x09, 0x80,
+    0x9e, 0x81, 0x3d, 0x3d, 0x01, 0x6b, 0x80, 0x03, 0x03, 0x75, 0x01, 0x73,
+    0x01, 0x6e, 0x0f, 0x04, 0x72, 0x73, 0x74, 0x79, 0x1a, 0x80, 0x75, 0x02,
+    0x2d, 0x01, 0x67, 0x01, 0x6b, 0x09, 0x80, 0x2d, 0x80, 0x2a, 0x80, 0x01,
+    0x02, 0x28, 0x04, 0x6f, 0x75, 0x67, 0x68, 0x02, 0x65, 0x65, 0x0d, 0x80,
+    0x28, 0x80, 0x22, 0x02, 0x11, 0x04, 0x75, 0x67, 0x68, 0x74, 0x02, 0x73,
+    0x65, 0x0d, 0x80, 0x11, 0x80, 0x0d, 0x84, 0xc2, 0xc2, 0x01, 0x6f, 0x06,
+    0x67, 0x65, 0x74, 0x68, 0x65, 0x72, 0x21, 0x03, 0x64, 0x61, 0x79, 0x23,
+    0x06, 0x6d, 0x6f, 0x72, 0x72, 0x6f, 0x77, 0x25, 0x81, 0x27, 0x27, 0x01,
+    0x6b, 0x80, 0x09, 0x80, 0x0c, 0x80, 0x03, 0x80, 0x03, 0x02, 0x45, 0x02,
+    0x6d, 0x65, 0x03, 0x72, 0x65, 0x64, 0x0c, 0x80, 0x45, 0x80, 0x01, 0x80,
+    0x43, 0x02, 0x32, 0x02, 0x6b, 0x65, 0x02, 0x6c, 0x6b, 0x0b, 0x80, 0x32,
+    0x80, 0x05, 0x02, 0x25, 0x02, 0x6c, 0x6c, 0x05, 0x61, 0x63, 0x68, 0x65,
+    0x72, 0x0e, 0x80, 0x25, 0x80, 0x01, 0x80, 0x1e, 0x02, 0x1b, 0x01, 0x79,
+    0x02, 0x65, 0x65, 0x0a, 0x80, 0x1b, 0x80, 0x12, 0x0a, 0xe0, 0x01, 0x66,
+    0x01, 0x6e, 0x37, 0x01, 0x72, 0x4a, 0x04, 0x74, 0x68, 0x65, 0x72, 0x4c,
+    0x01, 0x75, 0x4e, 0x02, 0x69, 0x6c, 0x59, 0x03, 0x76, 0x65, 0x72, 0x5b,
+    0x02, 0x6c, 0x64, 0x5d, 0x02, 0x77, 0x6e, 0x5f, 0x03, 0x70, 0x65, 0x6e,
+    0x61, 0x82, 0xe0, 0xe0, 0x01, 0x66, 0x03, 0x74, 0x65, 0x6e, 0x0c, 0x80,
+    0x1a, 0x80, 0x0c, 0x83, 0x8a, 0x8a, 0x01, 0x65, 0x02, 0x6c, 0x79, 0x0f,
+    0x02, 0x63, 0x65, 0x11, 0x80, 0x6e, 0x80, 0x32, 0x80, 0x08, 0x80, 0x6f,
+    0x80, 0x50, 0x02, 0x4e, 0x01, 0x74, 0x01, 0x72, 0x09, 0x80, 0x4e, 0x80,
+    0x2c, 0x80, 0x3a, 0x80, 0x33, 0x80, 0x26, 0x80, 0x14, 0x80, 0x0e, 0x8c,
+    0xb8, 0xce, 0x01, 0x6e, 0x01, 0x72, 0x62, 0x01, 0x73, 0x70, 0x01, 0x74,
+    0x77, 0x01, 0x6c, 0x79, 0x02, 0x62, 0x6f, 0x9c, 0x01, 0x04, 0x66, 0x74,
+    0x65, 0x72, 0xa9, 0x01, 0x04, 0x67, 0x61, 0x69, 0x6e, 0xb3, 0x01, 0x02,
+    0x69, 0x72, 0xb5, 0x01, 0x03, 0x77, 0x61, 0x79, 0xb7, 0x01, 0x06, 0x6d,
+    0x65, 0x72, 0x69, 0x63, 0x61, 0xb9, 0x01, 0x02, 0x64, 0x64, 0xbb, 0x01,
+    0x85, 0x59, 0xce, 0x01, 0x64, 0x01, 0x79, 0x1d, 0x05, 0x6f, 0x74, 0x68,
+    0x65, 0x72, 0x1f, 0x04, 0x69, 0x6d, 0x61, 0x6c, 0x21, 0x04, 0x73, 0x77,
+    0x65, 0x72, 0x23, 0x80, 0xce, 0x80, 0x26, 0x80, 0x21, 0x80, 0x18, 0x80,
+    0x17, 0x02, 0x87, 0x01, 0x65, 0x04, 0x6f, 0x75, 0x6e, 0x64, 0x0c, 0x80,
+    0x87, 0x80, 0x23, 0x81, 0x85, 0x85, 0x01, 0x6b, 0x80, 0x1e, 0x80, 0x79,
+    0x05, 0x63, 0x01, 0x6c, 0x02, 0x73, 0x6f, 0x1b, 0x03, 0x6f, 0x6e, 0x67,
+    0x1d, 0x04, 0x77, 0x61, 0x79, 0x73, 0x1f, 0x04, 0x6d, 0x6f, 0x73, 0x74,
+    0x21, 0x80, 0x63, 0x80, 0x23, 0x80, 0x0f, 0x80, 0x0d, 0x80, 0x06, 0x02,
+    0x4f, 0x02, 0x75, 0x74, 0x02, 0x76, 0x65, 0x0b, 0x80, 0x4f, 0x80, 0x06,
+    0x81, 0x2d, 0x2d, 0x04, 0x6e, 0x6f, 0x6f, 0x6e, 0x80, 0x02, 0x80, 0x1a,
+    0x80, 0x19, 0x80, 0x19, 0x80, 0x16, 0x80, 0x15, 0x86, 0x7b, 0xb0, 0x01,
+    0x6e, 0x01, 0x73, 0x25, 0x01, 0x74, 0x27, 0x01, 0x66, 0x34, 0x08, 0x6d,
+    0x70, 0x6f, 0x72, 0x74, 0x61, 0x6e, 0x74, 0x36, 0x03, 0x64, 0x65, 0x61,
+    0x38, 0x81, 0xb0, 0xb0, 0x02, 0x74, 0x6f, 0x80, 0x46, 0x80, 0xa9, 0x82,
+    0x99, 0x99, 0x01, 0x73, 0x02, 0x27, 0x73, 0x0b, 0x80, 0x39, 0x80, 0x04,
+    0x80, 0x52, 0x80, 0x0b, 0x80, 0x07, 0x02, 0xa3, 0x02, 0x6f, 0x75, 0x01,
+    0x65, 0x15, 0x82, 0xa3, 0xa3, 0x01, 0x72, 0x02, 0x6e, 0x67, 0x0b, 0x80,
+    0x5e, 0x80, 0x05, 0x02, 0x30, 0x02, 0x61, 0x72, 0x01, 0x73, 0x0a, 0x80,
+    0x30, 0x81, 0x02, 0x03, 0x06, 0x74, 0x65, 0x72, 0x64, 0x61, 0x79, 0x80,
+    0x03, 0x05, 0x95, 0x01, 0x65, 0x01, 0x69, 0x3e, 0x01, 0x61, 0x4f, 0x01,
+    0x6f, 0x73, 0x05, 0x75, 0x6e, 0x67, 0x72, 0x79, 0x86, 0x01, 0x83, 0x95,
+    0x95, 0x01, 0x72, 0x01, 0x6c, 0x12, 0x01, 0x61, 0x1e, 0x81, 0x49, 0x49,
+    0x01, 0x65, 0x80, 0x1e, 0x02, 0x29, 0x01, 0x70, 0x02, 0x6c, 0x6f, 0x0a,
+    0x80, 0x29, 0x80, 0x02, 0x02, 0x11, 0x01, 0x64, 0x01, 0x72, 0x09, 0x80,
+    0x11, 0x80, 0x08, 0x03, 0x7f, 0x01, 0x73, 0x01, 0x6d, 0x0d, 0x02, 0x67,
+    0x68, 0x0f, 0x80, 0x7f, 0x80, 0x46, 0x80, 0x15, 0x06, 0x73, 0x02, 0x76,
+    0x65, 0x01, 0x64, 0x1a, 0x01, 0x73, 0x1c, 0x02, 0x6e, 0x64, 0x1e, 0x02,
+    0x72, 0x64, 0x20, 0x03, 0x70, 0x70, 0x79, 0x22, 0x80, 0x73, 0x80, 0x6c,
+    0x80, 0x44, 0x80, 0x1b, 0x80, 0x0e, 0x80, 0x03, 0x03, 0x54, 0x01, 0x77,
+    0x02, 0x6d, 0x65, 0x0f, 0x03, 0x75, 0x73, 0x65, 0x11, 0x80, 0x54, 0x80,
+    0x1c, 0x80, 0x18, 0x80, 0x01, 0x06, 0x91, 0x01, 0x61, 0x01, 0x69, 0x3f,
+    0x01, 0x6f, 0x53, 0x01, 0x68, 0x6f, 0x01, 0x65, 0xa5, 0x01, 0x04, 0x72,
+    0x69, 0x74, 0x65, 0xb9, 0x01, 0x05, 0x91, 0x01, 0x73, 0x01, 0x79, 0x14,
+    0x01, 0x74, 0x16, 0x02, 0x6e, 0x74, 0x23, 0x02, 0x6c, 0x6b, 0x25, 0x80,
+    0x91, 0x80, 0x3f, 0x02, 0x3c, 0x02, 0x65, 0x72, 0x02, 0x63, 0x68, 0x0b,
+    0x80, 0x3c, 0x80, 0x06, 0x80, 0x24, 0x80, 0x0a, 0x02, 0x82, 0x02, 0x74,
+    0x68, 0x02, 0x6c, 0x6c, 0x12, 0x81, 0x82, 0x82, 0x03, 0x6f, 0x75, 0x74,
+    0x80, 0x08, 0x80, 0x52, 0x02, 0x69, 0x01, 0x72, 0x03, 0x75, 0x6c, 0x64,
+    0x1a, 0x03, 0x69, 0x01, 0x64, 0x01, 0x6b, 0x0d, 0x02, 0x6c, 0x64, 0x0f,
+    0x80, 0x69, 0x80, 0x31, 0x80, 0x15, 0x80, 0x48, 0x05, 0x65, 0x02, 0x61,
+    0x74, 0x01, 0x65, 0x13, 0x01, 0x69, 0x1f, 0x01, 0x6f, 0x32, 0x01, 0x79,
+    0x34, 0x80, 0x65, 0x02, 0x60, 0x01, 0x6e, 0x02, 0x72, 0x65, 0x0a, 0x80,
+    0x60, 0x80, 0x29, 0x03, 0x57, 0x02, 0x63, 0x68, 0x02, 0x6c, 0x65, 0x0f,
+    0x02, 0x74, 0x65, 0x11, 0x80, 0x57, 0x80, 0x0f, 0x80, 0x0a, 0x80, 0x3a,
+    0x80, 0x1e, 0x83, 0x61, 0x62, 0x02, 0x72, 0x65, 0x02, 0x6c, 0x6c, 0x10,
+    0x02, 0x6e, 0x74, 0x12, 0x80, 0x62, 0x80, 0x20, 0x80, 0x1d, 0x80, 0x42,
+    0x05, 0x8e, 0x01, 0x6f, 0x01, 0x72, 0x38, 0x01, 0x69, 0x47, 0x01, 0x61,
+    0x55, 0x01, 0x65, 0x71, 0x04, 0x8e, 0x01, 0x72, 0x04, 0x6c, 0x6c, 0x6f,
+    0x77, 0x18, 0x01, 0x75, 0x1a, 0x02, 0x6f, 0x64, 0x26, 0x81, 0x8e, 0x8e,
+    0x01, 0x6d, 0x80, 0x23, 0x80, 0x25, 0x02, 0x17, 0x02, 0x6e, 0x64, 0x01,
+    0x72, 0x0a, 0x80, 0x17, 0x80, 0x09, 0x80, 0x14, 0x02, 0x71, 0x02, 0x6f,
+    0x6d, 0x04, 0x69, 0x65, 0x6e, 0x64, 0x0d, 0x80, 0x71, 0x80, 0x04, 0x02,
+    0x3c, 0x03, 0x72, 0x73, 0x74, 0x02, 0x6e, 0x64, 0x0c, 0x80, 0x3c, 0x80,
+    0x38, 0x04, 0x13, 0x04, 0x74, 0x68, 0x65, 0x72, 0x02, 0x63, 0x65, 0x16,
+    0x01, 0x72, 0x18, 0x04, 0x6d, 0x69, 0x6c, 0x79, 0x1a, 0x80, 0x13, 0x80,
+    0x07, 0x80, 0x06, 0x80, 0x04, 0x02, 0x0f, 0x01, 0x77, 0x01, 0x65, 0x09,
+    0x80, 0x0f, 0x02, 0x0b, 0x01, 0x74, 0x01, 0x6c, 0x09, 0x80, 0x0b, 0x80,
+    0x01, 0x06, 0x77, 0x01, 0x65, 0x01, 0x79, 0x55, 0x02, 0x75, 0x74, 0x57,
+    0x01, 0x61, 0x59, 0x01, 0x6f, 0x6a, 0x02, 0x69, 0x67, 0x7c, 0x87, 0x77,
+    0x77, 0x02, 0x65, 0x6e, 0x04, 0x66, 0x6f, 0x72, 0x65, 0x29, 0x05, 0x63,
+    0x61, 0x75, 0x73, 0x65, 0x2b, 0x03, 0x6c, 0x6f, 0x77, 0x2d, 0x05, 0x74,
+    0x77, 0x65, 0x65, 0x6e, 0x2f, 0x01, 0x67, 0x31, 0x03, 0x69, 0x6e, 0x67,
+    0x3e, 0x80, 0x3b, 0x80, 0x28, 0x80, 0x1f, 0x80, 0x14, 0x80, 0x14, 0x02,
+    0x0d, 0x02, 0x69, 0x6e, 0x02, 0x61, 0x6e, 0x0b, 0x80, 0x0d, 0x80, 0x0a,
+    0x80, 0x04, 0x80, 0x6a, 0x80, 0x67, 0x02, 0x2f, 0x02, 0x63, 0x6b, 0x06,
+    0x74, 0x68, 0x72, 0x6f, 0x6f, 0x6d, 0x0f, 0x80, 0x2f, 0x80, 0x01, 0x03,
+    0x25, 0x01, 0x79, 0x02, 0x74, 0x68, 0x0e, 0x02, 0x6f, 0x6b, 0x10, 0x80,
+    0x25, 0x80, 0x0d, 0x80, 0x08, 0x80, 0x20, 0x05, 0x66, 0x01, 0x6f, 0x05,
+    0x75, 0x6d, 0x62, 0x65, 0x72, 0x25, 0x01, 0x65, 0x27, 0x03, 0x61, 0x6d,
+    0x65, 0x46, 0x04, 0x69, 0x67, 0x68, 0x74, 0x48, 0x82, 0x3f, 0x66, 0x01,
+    0x74, 0x01, 0x77, 0x0a, 0x80, 0x66, 0x80, 0x39, 0x80, 0x40, 0x05, 0x33,
+    0x01, 0x77, 0x02, 0x65, 0x64, 0x17, 0x02, 0x61, 0x72, 0x19, 0x03, 0x76,
+    0x65, 0x72, 0x1b, 0x02, 0x78, 0x74, 0x1d, 0x80, 0x33, 0x80, 0x1d, 0x80,
+    0x15, 0x80, 0x12, 0x80, 0x0e, 0x80, 0x2c, 0x80, 0x0a, 0x06, 0x5d, 0x01,
+    0x61, 0x01, 0x6f, 0x33, 0x01, 0x68, 0x58, 0x03, 0x69, 0x74, 0x79, 0x6b,
+    0x01, 0x6c, 0x6d, 0x02, 0x75, 0x74, 0x7c, 0x04, 0x5d, 0x01, 0x6e, 0x02,
+    0x6c, 0x6c, 0x11, 0x02, 0x6d, 0x65, 0x13, 0x01, 0x72, 0x15, 0x80, 0x5d,
+    0x80, 0x3b, 0x80, 0x24, 0x81, 0x0b, 0x0b, 0x02, 0x72, 0x79, 0x80, 0x09,
+    0x02, 0x3e, 0x01, 0x75, 0x01, 0x6d, 0x16, 0x02, 0x3e, 0x02, 0x6c, 0x64,
+    0x04, 0x6e, 0x74, 0x72, 0x79, 0x0d, 0x80, 0x3e, 0x80, 0x14, 0x02, 0x35,
+    0x01, 0x65, 0x05, 0x70, 0x75, 0x74, 0x65, 0x72, 0x0d, 0x80, 0x35, 0x80,
+    0x01, 0x02, 0x1a, 0x04, 0x61, 0x6e, 0x67, 0x65, 0x06, 0x69, 0x6c, 0x64,
+    0x72, 0x65, 0x6e, 0x11, 0x80, 0x1a, 0x80, 0x0b, 0x80, 0x12, 0x02, 0x0f,
+    0x03, 0x6f, 0x73, 0x65, 0x03, 0x61, 0x73, 0x73, 0x0d, 0x80, 0x0f, 0x80,
+    0x01, 0x80, 0x05, 0x0a, 0x5c, 0x01, 0x61, 0x01, 0x68, 0x4b, 0x01, 0x6f,
+    0x61, 0x01, 0x65, 0x90, 0x01, 0x04, 0x6d, 0x61, 0x6c, 0x6c, 0xb7, 0x01,
+    0x03, 0x75, 0x63, 0x68, 0xb9, 0x01, 0x04, 0x70, 0x65, 0x6c, 0x6c, 0xbb,
+    0x01, 0x01, 0x74, 0xbd, 0x01, 0x05, 0x63, 0x68, 0x6f, 0x6f, 0x6c, 0xeb,
+    0x01, 0x03, 0x69, 0x64, 0x65, 0xed, 0x01, 0x04, 0x5c, 0x02, 0x69, 0x64,
+    0x01, 0x79, 0x11, 0x02, 0x6d, 0x65, 0x13, 0x01, 0x77, 0x15, 0x80, 0x5c,
+    0x80, 0x2a, 0x80, 0x25, 0x80, 0x10, 0x02, 0x56, 0x01, 0x65, 0x01, 0x6f,
+    0x09, 0x80, 0x56, 0x02, 0x24, 0x01, 0x77, 0x03, 0x75, 0x6c, 0x64, 0x0b,
+    0x80, 0x24, 0x80, 0x16, 0x84, 0x4a, 0x4a, 0x02, 0x6d, 0x65, 0x03, 0x75,
+    0x6e, 0x64, 0x29, 0x02, 0x6f, 0x6e, 0x2b, 0x02, 0x6e, 0x67, 0x2d, 0x81,
+    0x4a, 0x4a, 0x01, 0x74, 0x02, 0x0f, 0x04, 0x68, 0x69, 0x6e, 0x67, 0x04,
+    0x69, 0x6d, 0x65, 0x73, 0x0f, 0x80, 0x0f, 0x80, 0x05, 0x80, 0x33, 0x80,
+    0x05, 0x80, 0x04, 0x05, 0x41, 0x01, 0x65, 0x06, 0x6e, 0x74, 0x65, 0x6e,
+    0x63, 0x65, 0x1f, 0x01, 0x74, 0x21, 0x01, 0x61, 0x23, 0x04, 0x63, 0x6f,
+    0x6e, 0x64, 0x25, 0x81, 0x41, 0x41, 0x01, 0x6d, 0x80, 0x0e, 0x80, 0x2b,
+    0x80, 0x22, 0x80, 0x0a, 0x80, 0x08, 0x80, 0x22, 0x80, 0x1f, 0x80, 0x19,
+    0x04, 0x17, 0x03, 0x75, 0x64, 0x79, 0x03, 0x69, 0x6c, 0x6c, 0x13, 0x01,
+    0x61, 0x15, 0x01, 0x6f, 0x22, 0x80, 0x17, 0x80, 0x16, 0x02, 0x12, 0x02,
+    0x72, 0x74, 0x02, 0x74, 0x65, 0x0b, 0x80, 0x12, 0x80, 0x09, 0x02, 0x10,
+    0x02, 0x72, 0x79, 0x01, 0x70, 0x0a, 0x80, 0x10, 0x80, 0x08, 0x80, 0x13,
+    0x80, 0x0b, 0x03, 0x5a, 0x01, 0x73, 0x01, 0x70, 0x11, 0x01, 0x6e, 0x13,
+    0x81, 0x1c, 0x5a, 0x01, 0x65, 0x80, 0x5a, 0x80, 0x51, 0x02, 0x10, 0x03,
+    0x64, 0x65, 0x72, 0x03, 0x74, 0x69, 0x6c, 0x0d, 0x80, 0x10, 0x80, 0x0b,
+    0x05, 0x58, 0x01, 0x61, 0x01, 0x6e, 0x2a, 0x02, 0x76, 0x65, 0x38, 0x02,
+    0x79, 0x65, 0x4b, 0x06, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x4d, 0x03,
+    0x58, 0x02, 0x63, 0x68, 0x03, 0x72, 0x74, 0x68, 0x0f, 0x01, 0x74, 0x11,
+    0x80, 0x58, 0x80, 0x11, 0x80, 0x07, 0x02, 0x21, 0x01, 0x64, 0x04, 0x6f,
+    0x75, 0x67, 0x68, 0x0c, 0x80, 0x21, 0x80, 0x07, 0x02, 0x1f, 0x01, 0x6e,
+    0x02, 0x72, 0x79, 0x11, 0x81, 0x1f, 0x1f, 0x03, 0x69, 0x6e, 0x67, 0x80,
+    0x02, 0x80, 0x15, 0x80, 0x11, 0x80, 0x0e, 0x03, 0x55, 0x01, 0x6f, 0x02,
+    0x61, 0x79, 0x20, 0x01, 0x69, 0x22, 0x83, 0x55, 0x55, 0x02, 0x77, 0x6e,
+    0x02, 0x65, 0x73, 0x11, 0x03, 0x6e, 0x27, 0x74, 0x13, 0x80, 0x37, 0x80,
+    0x21, 0x80, 0x10, 0x80, 0x37, 0x02, 0x36, 0x01, 0x64, 0x07, 0x66, 0x66,
+    0x65, 0x72, 0x65, 0x6e, 0x74, 0x0f, 0x80, 0x36, 0x80, 0x1c, 0x06, 0x4d,
+    0x01, 0x61, 0x01, 0x6f, 0x2f, 0x01, 0x79, 0x5f, 0x01, 0x65, 0x61, 0x01,
+    0x75, 0x6e, 0x01, 0x69, 0x7b, 0x04, 0x4d, 0x01, 0x6e, 0x02, 0x6b, 0x65,
+    0x16, 0x02, 0x64, 0x65, 0x18, 0x01, 0x79, 0x1a, 0x81, 0x2a, 0x4d, 0x01,
+    0x79, 0x80, 0x4d, 0x80, 0x48, 0x80, 0x35, 0x80, 0x34, 0x05, 0x42, 0x01,
+    0x72, 0x02, 0x73, 0x74, 0x28, 0x02, 0x76, 0x65, 0x2a, 0x04, 0x74, 0x68,
+    0x65, 0x72, 0x2c, 0x06, 0x75, 0x6e, 0x74, 0x61, 0x69, 0x6e, 0x2e, 0x02,
+    0x42, 0x01, 0x65, 0x04, 0x6e, 0x69, 0x6e, 0x67, 0x0c, 0x80, 0x42, 0x80,
+    0x03, 0x80, 0x2e, 0x80, 0x1b, 0x80, 0x17, 0x80, 0x05, 0x80, 0x3d, 0x82,
+    0x2f, 0x2f, 0x02, 0x61, 0x6e, 0x01, 0x6e, 0x0b, 0x80, 0x26, 0x80, 0x1d,
+    0x02, 0x28, 0x02, 0x63, 0x68, 0x02, 0x73, 0x74, 0x0b, 0x80, 0x28, 0x80,
+    0x20, 0x03, 0x0f, 0x03, 0x67, 0x68, 0x74, 0x02, 0x6c, 0x65, 0x10, 0x02,
+    0x73, 0x73, 0x12, 0x80, 0x0f, 0x80, 0x0a, 0x80, 0x07, 0x04, 0x47, 0x01,
+    0x69, 0x01, 0x6f, 0x3b, 0x01, 0x61, 0x4e, 0x01, 0x65, 0x69, 0x07, 0x47,
+    0x02, 0x6b, 0x65, 0x04, 0x74, 0x74, 0x6c, 0x65, 0x22, 0x02, 0x76, 0x65,
+    0x24, 0x02, 0x6e, 0x65, 0x26, 0x03, 0x67, 0x68, 0x74, 0x28, 0x02, 0x66,
+    0x65, 0x2a, 0x02, 0x73, 0x74, 0x2c, 0x80, 0x47, 0x80, 0x31, 0x80, 0x2f,
+    0x80, 0x27, 0x80, 0x11, 0x80, 0x0d, 0x80, 0x05, 0x03, 0x44, 0x02, 0x6f,
+    0x6b, 0x02, 0x6e, 0x67, 0x0f, 0x02, 0x76, 0x65, 0x11, 0x80, 0x44, 0x80,
+    0x38, 0x80, 0x02, 0x04, 0x20, 0x03, 0x72, 0x67, 0x65, 0x02, 0x6e, 0x64,
+    0x15, 0x02, 0x73, 0x74, 0x17, 0x03, 0x74, 0x65, 0x72, 0x19, 0x80, 0x20,
+    0x80, 0x1c, 0x80, 0x13, 0x80, 0x07, 0x03, 0x17, 0x01, 0x74, 0x01, 0x61,
+    0x14, 0x02, 0x66, 0x74, 0x21, 0x81, 0x06, 0x17, 0x03, 0x74, 0x65, 0x72,
+    0x80, 0x17, 0x02, 0x16, 0x02, 0x72, 0x6e, 0x02, 0x76, 0x65, 0x0b, 0x80,
+    0x16, 0x80, 0x04, 0x80, 0x10, 0x04, 0x41, 0x01, 0x6f, 0x02, 0x65, 0x74,
+    0x22, 0x01, 0x69, 0x24, 0x01, 0x72, 0x31, 0x82, 0x41, 0x41, 0x02, 0x6f,
+    0x64, 0x01, 0x74, 0x12, 0x81, 0x2b, 0x2b, 0x03, 0x62, 0x79, 0x65, 0x80,
+    0x02, 0x80, 0x0c, 0x80, 0x36, 0x02, 0x2e, 0x02, 0x76, 0x65, 0x02, 0x72,
+    0x6c, 0x0b, 0x80, 0x2e, 0x80, 0x06, 0x02, 0x29, 0x03, 0x65, 0x61, 0x74,
+    0x01, 0x6f, 0x0b, 0x80, 0x29, 0x02, 0x0c, 0x02, 0x75, 0x70, 0x01, 0x77,
+    0x0a, 0x80, 0x0c, 0x80, 0x09, 0x06, 0x3e, 0x05, 0x65, 0x6f, 0x70, 0x6c,
+    0x65, 0x01, 0x61, 0x22, 0x01, 0x6c, 0x36, 0x02, 0x75, 0x74, 0x54, 0x06,
+    0x69, 0x63, 0x74, 0x75, 0x72, 0x65, 0x56, 0x04, 0x6f, 0x69, 0x6e, 0x74,
+    0x58, 0x80, 0x3e, 0x03, 0x34, 0x02, 0x72, 0x74, 0x02, 0x67, 0x65, 0x10,
+    0x03, 0x70, 0x65, 0x72, 0x12, 0x80, 0x34, 0x80, 0x18, 0x80, 0x0d, 0x02,
+    0x30, 0x01, 0x61, 0x04, 0x65, 0x61, 0x73, 0x65, 0x1c, 0x03, 0x30, 0x02,
+    0x63, 0x65, 0x01, 0x79, 0x0e, 0x02, 0x6e, 0x74, 0x10, 0x80, 0x30, 0x80,
+    0x19, 0x80, 0x13, 0x80, 0x03, 0x80, 0x22, 0x80, 0x1a, 0x80, 0x18, 0x03,
+    0x31, 0x03, 0x6e, 0x6f, 0x77, 0x03, 0x69, 0x6e, 0x64, 0x12, 0x03, 0x65,
+    0x65, 0x70, 0x14, 0x80, 0x31, 0x80, 0x1b, 0x80, 0x12, 0x80, 0x2d, 0x80,
+    0x2c, 0x03, 0x27, 0x01, 0x69, 0x02, 0x65, 0x61, 0x1b, 0x02, 0x75, 0x6e,
+    0x28, 0x02, 0x27, 0x03, 0x67, 0x68, 0x74, 0x03, 0x76, 0x65, 0x72, 0x0d,
+    0x80, 0x27, 0x80, 0x09, 0x02, 0x1d, 0x01, 0x64, 0x03, 0x6c, 0x6c, 0x79,
+    0x0b, 0x80, 0x1d, 0x80, 0x06, 0x80, 0x0c,
+};
+
+#endif // ADAFRUIT_INTELLIKEYS_IK_DICT_EN_H
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Compile a word list into the word prediction dictionary (see src/IKPredict.h)
+
+Input has one word per line, most frequent first, optionally followed by a
+count: "word [count]". Without counts, frequency is derived from the rank.
+
+Output is a C header with the dictionary as a const byte array so that it
+stays in flash, e.g.
+
+    python3 tools/ik_dict.py tools/words_en.txt -o src/ik_dict_en.h -n ik_dict_en
+
+Dictionary format (little endian):
+
+    header: "IKD1", u32 total size, u16 word count, u8 max word length, u8 0
+    node:   u8  bit 7 word end, bit 0-5 child count
+            u8  word frequency, only if word end
+            u8  best frequency of the sub tree, only if it has children
+            per child, in descending best frequency:
+              u8 label length, label (lowercase a-z and '),
+              varint offset of child from this node (7 bits per byte, low
+              bits first, bit 7 set if more bytes follow), omitted for the
+              first child which directly follows this node
+
+Single child chains are merged into one edge label (radix trie). Nodes are
+laid out depth first, best child first, so child offsets are forward and
+mostly fit in 1-2 bytes. Suffixes are not shared (DAWG) since each node
+carries the best frequency of its sub tree, which lets lookup visit the most
+likely completions first.
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+HEADER_SIZE = 12
+WORD_MAX = 24  # IK_PREDICT_WORD_MAX
+CHILD_MAX = 63
+
+LICENSE = """/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (thach@tinyusb.org) for Adafruit Industries
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+"""
+
+
+class Node:
+    def __init__(self):
+        self.children = {}  # label -> Node
+        self.freq = 0  # 0: not a word end
+        self.best = 0
+        self.offset = 0
+
+
+def read_words(path):
+    words = {}
+    rank = 0
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            fields = line.split()
+            word = fields[0].lower()
+            if not re.fullmatch(r"[a-z']+", word) or len(word) > WORD_MAX:
+                print(f"skip '{fields[0]}'", file=sys.stderr)
+                continue
+            rank += 1
+            count = float(fields[1]) if len(fields) > 1 else 1.0 / rank
+            words[word] = max(words.get(word, 0), count)
+    return words
+
+
+def scale(words):
+    """Map counts to 1-255 on a log scale"""
+    top = max(words.values())
+    low = min(words.values())
+    span = math.log(top / low) if top > low else 1.0
+    return {w: 1 + int(254 * (1 - math.log(top / c) / span)) for w, c in words.items()}
+
+
+def build(freqs):
+    root = Node()
+    for word, freq in freqs.items():
+        node = root
+        for ch in word:
+            node = node.children.setdefault(ch, Node())
+        node.freq = freq
+    compress(root)
+    update_best(root)
+    return root
+
+
+def compress(node):
+    merged = {}
+    for label, child in node.children.items():
+        while len(child.children) == 1 and child.freq == 0:
+            (sub_label, sub), = child.children.items()
+            label += sub_label
+            child = sub
+        compress(child)
+        merged[label] = child
+    node.children = merged
+
+
+def update_best(node):
+    node.best = node.freq
+    for child in node.children.values():
+        node.best = max(node.best, update_best(child))
+    return node.best
+
+
+def sorted_children(node):
+    return sorted(node.children.items(), key=lambda kv: (-kv[1].best, kv[0]))
+
+
+def varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append(0x80 | (value & 0x7F))
+        value >>= 7
+    out.append(value)
+    return out
+
+
+def node_bytes(node):
+    out = bytearray([(0x80 if node.freq else 0) | len(node.children)])
+    if node.freq:
+        out.append(node.freq)
+    if node.children:
+        out.append(node.best)
+    for i, (label, child) in enumerate(sorted_children(node)):
+        out.append(len(label))
+        out += label.encode("ascii")
+        if i:
+            out += varint(max(child.offset - node.offset, 0))
+    return out
+
+
+def serialize(root, word_count):
+    # depth first so that a node and its best child are close together
+    order = []
+
+    def visit(node):
+        order.append(node)
+        for _, child in sorted_children(node):
+            visit(child)
+
+    visit(root)
+
+    for node in order:
+        if len(node.children) > CHILD_MAX:
+            sys.exit("too many children")
+
+    # offsets depend on varint sizes and only grow, iterate until stable
+    while True:
+        offset = HEADER_SIZE
+        changed = False
+        for node in order:
+            if node.offset != offset:
+                node.offset = offset
+                changed = True
+            offset += len(node_bytes(node))
+        if not changed:
+            break
+
+    out = bytearray(b"IKD1")
+    out += offset.to_bytes(4, "little")
+    out += word_count.to_bytes(2, "little")
+    out += bytes([WORD_MAX, 0])
+
+    for node in order:
+        out += node_bytes(node)
+
+    assert len(out) == offset
+    return out, len(order)
+
+
+def write_header(path, name, data, source):
+    base = os.path.splitext(os.path.basename(path))[0]
+    guard = f"ADAFRUIT_INTELLIKEYS_{base.upper()}_H"
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(LICENSE)
+        f.write(f"\n// Generated by tools/ik_dict.py from {source}, do not edit\n\n")
+        f.write(f"#ifndef {guard}\n#define {guard}\n\n#include <stdint.h>\n\n")
+        f.write(f"static const uint8_t {name}[{len(data)}] = {{\n")
+        # 12 bytes per line stays within 80 columns
+        for i in range(0, len(data), 12):
+            chunk = ", ".join(f"0x{b:02x}" for b in data[i : i + 12])
+            f.write(f"    {chunk},\n")
+        f.write(f"}};\n\n#endif // {guard}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("words", help="word list, most frequent first")
+    parser.add_argument("-o", "--output", help="C header to write")
+    parser.add_argument("-n", "--name", default="ik_dict", help="array name")
+    args = parser.parse_args()
+
+    freqs = scale(read_words(args.words))
+    root = build(freqs)
+    data, nodes = serialize(root, len(freqs))
+
+    if args.output:
+        write_header(args.output, args.name, data, args.words.replace("\\", "/"))
+
+    text = sum(len(w) + 1 for w in freqs)
+    print(
+        f"{len(freqs)} words, {nodes} nodes, {len(data)} bytes "
+        f"({len(data) / len(freqs):.1f} bytes/word, plain text {text} bytes)"
+    )
+
+
+if __name__ == "__main__":
+    main()